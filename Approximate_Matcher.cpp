@@ -0,0 +1,237 @@
+/*
+ * Approximate_Matcher implementation file
+ */
+
+#include <algorithm>
+#include <climits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Approximate_Matcher.h"
+#include "Compile_Limits.h"
+#include "Position_Automaton.h"
+#include "Regex_AST.h"
+#include "Regex_Optimizer.h"
+#include "Regex_Parser.h"
+
+using namespace std;
+
+const unsigned Approximate_Matcher::NO_MATCH {UINT_MAX};
+
+Approximate_Matcher::Approximate_Matcher(const string& regex,
+    unsigned errors, const Compile_Limits& limits) : max_errors(errors)
+{
+  Compile_Budget budget {limits};
+  auto tree {Regex_Optimizer::optimize(Regex_Parser::regex_to_ast(regex))};
+  Position_Automaton automaton {*tree};
+
+  size_t positions {automaton.size()};
+  words = (positions + 63) / 64;
+  end_marker = automaton.get_end_marker();
+
+  // Words of the follow and matching tables
+  size_t table_words {(words * 8 + 1) * 256 * words};
+  if (table_words > limits.max_table_bytes / sizeof(uint64_t))
+  {
+    throw Compile_Limit_Error(Compile_Limit_Error::Reason::TABLE_BYTES,
+        positions);
+  }
+
+  auto add = [&](const Position_Set& set, uint64_t* out)
+  {
+    set.for_each([&](size_t p)
+    {
+      out[p / 64] |= uint64_t {1} << (p % 64);
+    });
+  };
+
+  first.assign(words, 0);
+  add(automaton.get_first(), first.data());
+
+  matching.assign(256 * words, 0);
+  for (size_t p {0}; p < positions; p++)
+  {
+    const auto& chars {automaton.get_chars(p)};
+    for (size_t c {0}; c < chars.size(); c++)
+    {
+      if (chars.test(c))
+      {
+        matching[c * words + p / 64] |= uint64_t {1} << (p % 64);
+      }
+    }
+  }
+
+  // Each entry is the entry without its lowest bit plus that position
+  follow.assign(words * 8 * 256 * words, 0);
+  for (size_t j {0}; j < words * 8; j++)
+  {
+    budget.check(0);
+    for (unsigned b {1}; b < 256; b++)
+    {
+      auto row {follow.begin() + (j * 256 + b) * words};
+      auto rest {follow.begin() + (j * 256 + (b & (b - 1))) * words};
+      copy(rest, rest + words, row);
+
+      size_t p {j * 8 + __builtin_ctz(b)};
+      if (p < positions)
+      {
+        add(automaton.get_follow(p), &*row);
+      }
+    }
+  }
+}
+
+void Approximate_Matcher::follow_all(const uint64_t* set,
+    uint64_t* out) const
+{
+  for (size_t w {0}; w < words; w++)
+  {
+    size_t j {w * 8};
+    for (uint64_t x {set[w]}; x != 0; x >>= 8, j++)
+    {
+      unsigned b {static_cast<unsigned>(x & 255)};
+      if (b == 0)
+        continue;
+
+      const uint64_t* row {&follow[(j * 256 + b) * words]};
+      for (size_t v {0}; v < words; v++)
+      {
+        out[v] |= row[v];
+      }
+    }
+  }
+}
+
+void Approximate_Matcher::start(vector<uint64_t>& levels) const
+{
+  levels.assign((max_errors + 1) * words, 0);
+  copy(first.begin(), first.end(), levels.begin());
+
+  // Deleting positions of the regex before the input starts
+  for (unsigned i {1}; i <= max_errors; i++)
+  {
+    auto below {&levels[(i - 1) * words]};
+    copy(below, below + words, &levels[i * words]);
+    follow_all(below, &levels[i * words]);
+  }
+}
+
+void Approximate_Matcher::step(const vector<uint64_t>& levels,
+    unsigned char c, bool search, vector<uint64_t>& next,
+    vector<uint64_t>& scratch) const
+{
+  const uint64_t* matches_c {&matching[c * words]};
+  fill(next.begin(), next.end(), 0);
+
+  for (unsigned i {0}; i <= max_errors; i++)
+  {
+    const uint64_t* before {&levels[i * words]};
+    uint64_t* after {&next[i * words]};
+
+    // Matching c at the positions of the level
+    for (size_t w {0}; w < words; w++)
+    {
+      scratch[w] = before[w] & matches_c[w];
+    }
+
+    follow_all(scratch.data(), after);
+
+    if (i == 0)
+    {
+      if (search)
+      {
+        for (size_t w {0}; w < words; w++)
+        {
+          after[w] |= first[w];
+        }
+      }
+
+      continue;
+    }
+
+    /*
+     * One more error than the level below: inserting c keeps the
+     * positions before c, substituting c follows any of them, and
+     * deleting a position follows any position after c. At most i - 1
+     * errors is also at most i.
+     */
+    const uint64_t* below_before {&levels[(i - 1) * words]};
+    const uint64_t* below_after {&next[(i - 1) * words]};
+    for (size_t w {0}; w < words; w++)
+    {
+      scratch[w] = below_before[w] | below_after[w];
+      after[w] |= scratch[w];
+    }
+
+    follow_all(scratch.data(), after);
+  }
+}
+
+unsigned Approximate_Matcher::accepting_level(
+    const vector<uint64_t>& levels) const
+{
+  // Each level holds the one below it
+  for (unsigned i {0}; i <= max_errors; i++)
+  {
+    if ((levels[i * words + end_marker / 64] >> (end_marker % 64)) & 1)
+    {
+      return i;
+    }
+  }
+
+  return NO_MATCH;
+}
+
+unsigned Approximate_Matcher::distance(string_view input) const
+{
+  vector<uint64_t> levels;
+  vector<uint64_t> next((max_errors + 1) * words);
+  vector<uint64_t> scratch(words);
+  start(levels);
+
+  for (auto c : input)
+  {
+    step(levels, c, false, next, scratch);
+    levels.swap(next);
+
+    // Stop once no position is reachable with max_errors edits
+    auto last {levels.begin() + max_errors * words};
+    if (all_of(last, levels.end(), [](uint64_t w) { return w == 0; }))
+    {
+      return NO_MATCH;
+    }
+  }
+
+  return accepting_level(levels);
+}
+
+vector<Approximate_Matcher::Match> Approximate_Matcher::search(
+    string_view input) const
+{
+  vector<uint64_t> levels;
+  vector<uint64_t> next((max_errors + 1) * words);
+  vector<uint64_t> scratch(words);
+  start(levels);
+
+  vector<Match> matches;
+  auto d {accepting_level(levels)};
+  if (d != NO_MATCH)
+  {
+    matches.push_back({0, d});
+  }
+
+  for (size_t i {0}; i < input.size(); i++)
+  {
+    step(levels, input[i], true, next, scratch);
+    levels.swap(next);
+
+    d = accepting_level(levels);
+    if (d != NO_MATCH)
+    {
+      matches.push_back({i + 1, d});
+    }
+  }
+
+  return matches;
+}
@@ -0,0 +1,117 @@
+#ifndef APPROXIMATE_MATCHER_H
+#define APPROXIMATE_MATCHER_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Compile_Limits.h"
+
+/*
+ * An approximate matcher, recognizing the strings within a number of
+ * edits of a string of a regex. An edit inserts, deletes or substitutes
+ * one character.
+ *
+ * The matcher runs the regex's position automaton on bitsets, one set of
+ * positions per number of errors, as agrep does (Wu and Manber): level i
+ * holds the positions reachable with at most i edits, and each byte
+ * updates every level from itself and the level below with word wide
+ * operations. The followpos union of a set of positions is looked up a
+ * byte of the set at a time in precomputed tables (Navarro and Raffinot),
+ * so each byte costs about (k + 1) * m * m / 512 word operations for m
+ * positions and k errors, however the regex branches. The tables take
+ * about 4 * m * m bytes, which counts against max_table_bytes.
+ */
+class Approximate_Matcher
+{
+  private:
+
+    // Number of 64 bit words in a set of positions
+    size_t words;
+
+    unsigned max_errors;
+
+    size_t end_marker;
+
+    // firstpos of the regex
+    std::vector<uint64_t> first;
+
+    // The positions matching each byte, at byte * words
+    std::vector<uint64_t> matching;
+
+    /*
+     * The union of followpos of the positions set in byte b of a set of
+     * positions, for each byte j of the set, at (j * 256 + b) * words
+     */
+    std::vector<uint64_t> follow;
+
+    /*
+     * ORs the union of followpos of the positions in set into out
+     */
+    void follow_all(const uint64_t* set, uint64_t* out) const;
+
+    /*
+     * Sets the levels to the positions reachable before any input
+     */
+    void start(std::vector<uint64_t>& levels) const;
+
+    /*
+     * Computes the levels after reading c from the levels before it,
+     * using scratch as a set of positions. With search, a match may also
+     * start after c.
+     */
+    void step(const std::vector<uint64_t>& levels, unsigned char c,
+        bool search, std::vector<uint64_t>& next,
+        std::vector<uint64_t>& scratch) const;
+
+    /*
+     * Returns the fewest errors with which levels accept, or NO_MATCH
+     */
+    unsigned accepting_level(const std::vector<uint64_t>& levels) const;
+
+  public:
+
+    /*
+     * A substring of the input ending at end is distance edits from the
+     * regex, and none ending there is closer
+     */
+    class Match
+    {
+      public:
+        size_t end;
+        unsigned distance;
+    };
+
+    /*
+     * Returned by distance() if the input is more than max_errors edits
+     * from the regex
+     */
+    static const unsigned NO_MATCH;
+
+    /*
+     * Compiles a regex into a matcher tolerating up to max_errors edits.
+     * Throws std::runtime_error if the regex is invalid, and
+     * Compile_Limit_Error if the tables would pass max_table_bytes, or
+     * the compilation runs out of time or is cancelled.
+     */
+    Approximate_Matcher(const std::string& regex, unsigned max_errors,
+        const Compile_Limits& limits = Compile_Limits());
+
+    /*
+     * Returns the edit distance from the whole input to the closest
+     * string of the regex, or NO_MATCH if it is more than max_errors
+     */
+    unsigned distance(std::string_view input) const;
+
+    /*
+     * Returns, for each offset of the input where a substring within
+     * max_errors edits of the regex ends, the offset and the distance of
+     * the closest such substring, in order of offset
+     */
+    std::vector<Match> search(std::string_view input) const;
+
+    unsigned get_max_errors() const { return max_errors; }
+};
+
+#endif
@@ -0,0 +1,360 @@
+/*
+ * Capture_Matcher implementation file
+ */
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Capture_Matcher.h"
+#include "Regex_AST.h"
+#include "Regex_Optimizer.h"
+#include "Regex_Parser.h"
+
+using namespace std;
+
+typedef Regex_Node::Type Type;
+
+static const char ALPHABET_START {' '};
+static const char ALPHABET_END {'~'};
+
+const uint32_t Capture_Matcher::DEAD {0};
+const uint32_t Capture_Matcher::START {1};
+
+/*
+ * Computes the position automaton of a tree with capture groups.
+ * Position p is state p + 2 of the matcher. Every transition records the
+ * slots it sets: the ends of the groups it leaves, the starts of the
+ * groups it enters, and both ends of the groups it skips by matching
+ * them with the empty string.
+ */
+class Glushkov_Builder
+{
+  public:
+
+    // A position in firstpos or lastpos of a subtree
+    class Entry
+    {
+      public:
+        size_t position;
+
+        // Slots set when entering (firstpos) or leaving (lastpos) the
+        // subtree through this position
+        vector<uint16_t> slots;
+    };
+
+    // nullable, firstpos and lastpos of a subtree
+    class Result
+    {
+      public:
+        bool nullable;
+
+        // Slots set when the subtree matches the empty string
+        vector<uint16_t> empty_slots;
+
+        vector<Entry> first;
+        vector<Entry> last;
+    };
+
+    // The characters matched at each position
+    vector<Char_Set> chars;
+
+    // Slots set by the transition between two states
+    map<pair<uint32_t, uint32_t>, vector<uint16_t>> edges;
+
+    /*
+     * Records a transition into position q.
+     */
+    void add_edge(uint32_t from, size_t q, vector<uint16_t> slots)
+    {
+      std::sort(slots.begin(), slots.end());
+      slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+
+      // The same transition with different group boundaries is ambiguous
+      auto ret {edges.emplace(make_pair(from, q + 2), slots)};
+      if (!ret.second && ret.first->second != slots)
+      {
+        throw runtime_error("Pattern is not one-pass");
+      }
+    }
+
+    /*
+     * Records the transitions from every position in last to every
+     * position in first
+     */
+    void connect(const vector<Entry>& last, const vector<Entry>& first)
+    {
+      for (auto& p : last)
+      {
+        for (auto& q : first)
+        {
+          auto slots {p.slots};
+          slots.insert(slots.end(), q.slots.begin(), q.slots.end());
+          add_edge(p.position + 2, q.position, slots);
+        }
+      }
+    }
+
+    Result walk(const Regex_Node& node)
+    {
+      switch (node.type)
+      {
+        case Type::EMPTY:
+          return {true, {}, {}, {}};
+
+        case Type::CHARACTER:
+          chars.push_back(node.chars);
+          return {false, {}, {{chars.size() - 1, {}}},
+            {{chars.size() - 1, {}}}};
+
+        case Type::GROUP:
+        {
+          uint16_t open (2 * node.group);
+          uint16_t close (2 * node.group + 1);
+
+          auto ret {walk(*node.children.front())};
+          for (auto& e : ret.first)
+            e.slots.push_back(open);
+
+          for (auto& e : ret.last)
+            e.slots.push_back(close);
+
+          if (ret.nullable)
+          {
+            ret.empty_slots.push_back(open);
+            ret.empty_slots.push_back(close);
+          }
+          return ret;
+        }
+
+        case Type::CLOSURE:
+        {
+          // Each iteration leaves and re-enters the groups inside
+          auto ret {walk(*node.children.front())};
+          connect(ret.last, ret.first);
+
+          // Zero iterations leave the groups inside unset
+          ret.nullable = true;
+          ret.empty_slots.clear();
+          return ret;
+        }
+
+        case Type::ALTERNATION:
+        {
+          Result ret {false, {}, {}, {}};
+          for (auto& child : node.children)
+          {
+            auto r {walk(*child)};
+
+            // The first nullable alternative matches the empty string
+            if (r.nullable && !ret.nullable)
+            {
+              ret.nullable = true;
+              ret.empty_slots = r.empty_slots;
+            }
+
+            ret.first.insert(ret.first.end(), r.first.begin(), r.first.end());
+            ret.last.insert(ret.last.end(), r.last.begin(), r.last.end());
+          }
+          return ret;
+        }
+
+        case Type::CONCATENATION:
+        {
+          Result ret {true, {}, {}, {}};
+          for (auto& child : node.children)
+          {
+            auto r {walk(*child)};
+            connect(ret.last, r.first);
+
+            // Entering the child after skipping the nullable prefix
+            if (ret.nullable)
+            {
+              for (auto e : r.first)
+              {
+                e.slots.insert(e.slots.end(), ret.empty_slots.begin(),
+                    ret.empty_slots.end());
+                ret.first.push_back(e);
+              }
+            }
+
+            // Leaving the prefix, then skipping the nullable child
+            if (r.nullable)
+            {
+              for (auto& e : ret.last)
+              {
+                e.slots.insert(e.slots.end(), r.empty_slots.begin(),
+                    r.empty_slots.end());
+              }
+            }
+            else
+            {
+              ret.last.clear();
+            }
+
+            ret.last.insert(ret.last.end(), r.last.begin(), r.last.end());
+            ret.nullable &= r.nullable;
+            ret.empty_slots.insert(ret.empty_slots.end(),
+                r.empty_slots.begin(), r.empty_slots.end());
+          }
+          return ret;
+        }
+      }
+
+      return {false, {}, {}, {}};
+    }
+};
+
+Capture_Matcher::Capture_Matcher(const string& regex)
+{
+  // Keep the groups, simplifying only inside them
+  auto tree {Regex_Optimizer::optimize(Regex_Parser::regex_to_ast(regex),
+      true)};
+
+  groups = tree->group_count();
+  build(*tree);
+}
+
+void Capture_Matcher::build(const Regex_Node& tree)
+{
+  Glushkov_Builder builder;
+  auto root {builder.walk(tree)};
+  for (auto& q : root.first)
+  {
+    builder.add_edge(START, q.position, q.slots);
+  }
+
+  size_t positions {builder.chars.size()};
+  size_t states {positions + 2};
+
+  // One-pass: at most one transition out of a state over each character
+  vector<Char_Set> seen(states);
+  for (auto& edge : builder.edges)
+  {
+    auto& chars {builder.chars[edge.first.second - 2]};
+    if ((seen[edge.first.first] & chars).any())
+    {
+      throw runtime_error("Pattern is not one-pass");
+    }
+
+    seen[edge.first.first] |= chars;
+  }
+
+  // Characters matched by the same positions share a class
+  map<vector<bool>, uint8_t> classes {{vector<bool>(positions), 0}};
+  byte_class.fill(0);
+  for (char c {ALPHABET_START}; c <= ALPHABET_END; c++)
+  {
+    vector<bool> signature(positions);
+    for (size_t p {0}; p < positions; p++)
+    {
+      signature[p] = builder.chars[p].test(c);
+    }
+
+    auto it {classes.emplace(signature, classes.size()).first};
+    byte_class[static_cast<unsigned char>(c)] = it->second;
+  }
+
+  class_count = classes.size();
+
+  // Intern the action lists, action 0 being the empty list
+  map<vector<uint16_t>, uint32_t> actions {{{}, 0}};
+  action_begin = {0, 0};
+  auto intern = [&](const vector<uint16_t>& slots)
+  {
+    auto ret {actions.emplace(slots, actions.size())};
+    if (ret.second)
+    {
+      action_slots.insert(action_slots.end(), slots.begin(), slots.end());
+      action_begin.push_back(action_slots.size());
+    }
+
+    return ret.first->second;
+  };
+
+  table.assign(states * class_count, {DEAD, 0});
+  for (auto& edge : builder.edges)
+  {
+    uint32_t from {edge.first.first};
+    uint32_t to {edge.first.second};
+    Transition t {to, intern(edge.second)};
+
+    for (char c {ALPHABET_START}; c <= ALPHABET_END; c++)
+    {
+      if (builder.chars[to - 2].test(c))
+      {
+        table[from * class_count + byte_class[c]] = t;
+      }
+    }
+  }
+
+  // Accepting states leave every group enclosing their position
+  accepting.assign(states, 0);
+  final_action.assign(states, 0);
+  if (root.nullable)
+  {
+    accepting[START] = 1;
+    final_action[START] = intern(root.empty_slots);
+  }
+
+  for (auto& p : root.last)
+  {
+    accepting[p.position + 2] = 1;
+    final_action[p.position + 2] = intern(p.slots);
+  }
+}
+
+bool Capture_Matcher::match(string_view input, vector<size_t>& slots) const
+{
+  slots.assign(2 * (groups + 1), string::npos);
+
+  uint32_t state {START};
+  for (size_t i {0}; i < input.size(); i++)
+  {
+    auto& t {table[state * class_count +
+      byte_class[static_cast<unsigned char>(input[i])]]};
+
+    if (t.dst == DEAD)
+    {
+      return false;
+    }
+
+    run(t.action, i, slots);
+    state = t.dst;
+  }
+
+  if (!accepting[state])
+  {
+    return false;
+  }
+
+  run(final_action[state], input.size(), slots);
+  slots[0] = 0;
+  slots[1] = input.size();
+  return true;
+}
+
+bool Capture_Matcher::match(string_view input,
+    vector<string_view>& group_text) const
+{
+  vector<size_t> slots;
+  if (!match(input, slots))
+  {
+    return false;
+  }
+
+  group_text.assign(groups + 1, string_view());
+  for (unsigned g {0}; g <= groups; g++)
+  {
+    if (slots[2 * g] != string::npos && slots[2 * g + 1] != string::npos)
+    {
+      group_text[g] = input.substr(slots[2 * g],
+          slots[2 * g + 1] - slots[2 * g]);
+    }
+  }
+
+  return true;
+}
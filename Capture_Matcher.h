@@ -0,0 +1,114 @@
+#ifndef CAPTURE_MATCHER_H
+#define CAPTURE_MATCHER_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Regex_AST.h"
+
+/*
+ * A one-pass matcher that extracts capture groups.
+ *
+ * The matcher is the position automaton of the regex with capture
+ * groups kept. If that automaton is deterministic (the regex is one-pass),
+ * each transition can carry the group boundaries it crosses, so the
+ * groups are extracted in a single linear pass with no backtracking.
+ *
+ * A group that repeats captures its last iteration, and a group that
+ * does not take part in the match is unset.
+ */
+class Capture_Matcher
+{
+  private:
+
+    // A transition of the one-pass automaton
+    class Transition
+    {
+      public:
+        uint32_t dst;
+
+        // Index of the transition's actions
+        uint32_t action;
+    };
+
+    // The equivalence class of each byte
+    std::array<uint8_t, 256> byte_class;
+
+    unsigned class_count;
+
+    // Transition table, indexed by state * class_count + class
+    std::vector<Transition> table;
+
+    // accepting[s] != 0 iff s is an accepting state
+    std::vector<uint8_t> accepting;
+
+    // The actions to run when the input ends in each state
+    std::vector<uint32_t> final_action;
+
+    /*
+     * Actions are lists of slots to set to the current input offset.
+     * Action a is slots [action_begin[a], action_begin[a + 1]) of
+     * action_slots. Action 0 is empty.
+     */
+    std::vector<uint32_t> action_begin;
+    std::vector<uint16_t> action_slots;
+
+    unsigned groups;
+
+    /*
+     * Builds the matcher from a syntax tree with capture groups.
+     * Throws std::runtime_error if the tree is not one-pass.
+     */
+    void build(const Regex_Node& tree);
+
+    /*
+     * Sets the slots of an action to offset
+     */
+    void run(uint32_t action, size_t offset, std::vector<size_t>& slots) const
+    {
+      for (auto i {action_begin[action]}; i < action_begin[action + 1]; i++)
+      {
+        slots[action_slots[i]] = offset;
+      }
+    }
+
+  public:
+
+    /*
+     * The dead state and the start state
+     */
+    static const uint32_t DEAD;
+    static const uint32_t START;
+
+    /*
+     * Compiles a regex into a one-pass matcher.
+     * Throws std::runtime_error if the regex is invalid or not one-pass.
+     */
+    Capture_Matcher(const std::string& regex);
+
+    /*
+     * Returns the number of capture groups
+     */
+    unsigned group_count() const { return groups; }
+
+    /*
+     * Checks if the matcher recognizes the whole input. If it does,
+     * group g is [slots[2g], slots[2g + 1]), where group 0 is the whole
+     * input, and unset groups are std::string::npos.
+     * Allocates only if slots has less than 2 * (group_count() + 1)
+     * elements of capacity.
+     */
+    bool match(std::string_view input, std::vector<size_t>& slots) const;
+
+    /*
+     * Checks if the matcher recognizes the whole input, storing the
+     * groups' text in groups. Unset groups have a null data().
+     */
+    bool match(std::string_view input,
+        std::vector<std::string_view>& groups) const;
+};
+
+#endif
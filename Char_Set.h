@@ -0,0 +1,12 @@
+#ifndef CHAR_SET_H
+#define CHAR_SET_H
+
+#include <bitset>
+
+/*
+ * A set of characters indexed by character value.
+ * Only the ASCII range is representable.
+ */
+typedef std::bitset<128> Char_Set;
+
+#endif
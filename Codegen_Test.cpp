@@ -0,0 +1,56 @@
+/*
+ * Checks the generated and constexpr matchers against the runtime matcher
+ */
+
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "Constexpr_Regex.h"
+#include "Regex_Compiler.h"
+#include "codegen_table.h"
+#include "codegen_direct.h"
+
+using namespace std;
+
+static const int INPUTS {200000};
+static const size_t MAX_LENGTH {24};
+
+// The same pattern, compiled by the C++ compiler
+static constexpr auto constexpr_matcher {
+  Constexpr_Regex::compile<codegen_table_pattern>()};
+
+int main()
+{
+  auto matcher {Regex_Compiler::compile(codegen_table_pattern)};
+
+  // Draw from the pattern's characters, plus a few it does not use
+  string chars {string(codegen_table_pattern) + "xyzXYZ09 ~\x7f\xff"};
+
+  mt19937 rng {1};
+  int accepted {0};
+  for (int i {0}; i < INPUTS; i++)
+  {
+    string input;
+    size_t length {rng() % (MAX_LENGTH + 1)};
+    for (size_t j {0}; j < length; j++)
+    {
+      input += chars[rng() % chars.size()];
+    }
+
+    bool expected {matcher->accept(input)};
+    if (codegen_table_accept(input) != expected ||
+        codegen_direct_accept(input) != expected ||
+        constexpr_matcher.accept(input) != expected)
+    {
+      cerr << "Generated matcher disagrees on \"" << input << "\"" << endl;
+      return 1;
+    }
+
+    accepted += expected;
+  }
+
+  cout << INPUTS << " inputs, " << accepted << " accepted, no mismatches"
+    << endl;
+  return 0;
+}
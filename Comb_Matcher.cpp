@@ -0,0 +1,310 @@
+/*
+ * Comb_Matcher implementation file
+ */
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "Comb_Matcher.h"
+#include "DFA_Matcher.h"
+
+using namespace std;
+
+// Owner of the free slots while the comb is built
+static const uint32_t FREE {numeric_limits<uint32_t>::max()};
+
+Comb_Matcher::Comb_Matcher(const DFA_Matcher& matcher)
+{
+  class_count = matcher.get_class_count();
+  start_state = matcher.get_start_state();
+
+  // Any byte of each class, to read the matcher's table by class
+  vector<unsigned char> representative(class_count);
+  for (unsigned c {0}; c < 256; c++)
+  {
+    byte_class[c] = matcher.get_byte_class(c);
+    representative[byte_class[c]] = c;
+  }
+
+  // The matcher's table, read with its width picked once
+  size_t states {matcher.size()};
+  vector<uint32_t> targets(states * class_count);
+  matcher.with_rows([&](auto rows)
+  {
+    for (uint32_t s {0}; s < states; s++)
+    {
+      for (unsigned cls {0}; cls < class_count; cls++)
+      {
+        targets[s * class_count + cls] = rows.delta(s, representative[cls]);
+      }
+    }
+  });
+
+  vector<uint32_t> deflt(states, DFA_Matcher::DEAD);
+  vector<uint32_t> base(states, 0);
+  accepting.assign(states, 0);
+
+  // The classes of each state that differ from its default
+  vector<vector<uint8_t>> exceptions(states);
+  for (uint32_t s {0}; s < states; s++)
+  {
+    accepting[s] = matcher.is_accepting(s);
+
+    map<uint32_t, unsigned> counts;
+    for (unsigned cls {0}; cls < class_count; cls++)
+    {
+      counts[targets[s * class_count + cls]]++;
+    }
+
+    deflt[s] = std::max_element(counts.begin(), counts.end(),
+        [](auto& a, auto& b) { return a.second < b.second; })->first;
+
+    for (unsigned cls {0}; cls < class_count; cls++)
+    {
+      if (targets[s * class_count + cls] != deflt[s])
+      {
+        exceptions[s].push_back(cls);
+      }
+    }
+  }
+
+  // First fit, densest rows first while the comb is still empty
+  vector<uint32_t> order(states);
+  for (uint32_t s {0}; s < states; s++)
+  {
+    order[s] = s;
+  }
+
+  std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+  {
+    return exceptions[a].size() > exceptions[b].size();
+  });
+
+  // Every row fits, so lookups never index past the end
+  vector<uint32_t> check(class_count, FREE);
+  vector<uint32_t> next(class_count, DFA_Matcher::DEAD);
+
+  size_t first_free {0};
+  for (auto s : order)
+  {
+    auto& row {exceptions[s]};
+    if (row.empty())
+      break;
+
+    // The row's first exception takes a free slot at or after first_free
+    size_t offset {first_free > row.front() ? first_free - row.front() : 0};
+    for (;; offset++)
+    {
+      if (offset + class_count > check.size())
+      {
+        check.resize(offset + class_count, FREE);
+        next.resize(offset + class_count, DFA_Matcher::DEAD);
+      }
+
+      if (std::all_of(row.begin(), row.end(),
+            [&](uint8_t cls) { return check[offset + cls] == FREE; }))
+        break;
+    }
+
+    base[s] = offset;
+    for (auto cls : row)
+    {
+      check[offset + cls] = s;
+      next[offset + cls] = targets[s * class_count + cls];
+    }
+
+    while (first_free < check.size() && check[first_free] != FREE)
+    {
+      first_free++;
+    }
+  }
+
+  /*
+   * Entries as narrow as the states allow, leaving the largest value
+   * free, and narrow offsets if the comb is short. Keep the plain table
+   * if the comb is no smaller.
+   */
+  size_t width {states < 1 << 8 ? 1u : states < 1 << 16 ? 2u : 4u};
+  size_t base_width {width < 4 && check.size() <= 1 << 16 ? 2u : 4u};
+  size_t comb_bytes {states * (width + base_width) +
+    check.size() * 2 * width};
+
+  if (comb_bytes >= targets.size() * width)
+  {
+    switch (width)
+    {
+      case 1:
+        set_dense<uint8_t>(targets);
+        break;
+      case 2:
+        set_dense<uint16_t>(targets);
+        break;
+      default:
+        set_dense<uint32_t>(targets);
+    }
+  }
+  else if (width == 1)
+  {
+    set_comb<uint8_t, uint16_t>(deflt, base, check, next);
+  }
+  else if (width == 2 && base_width == 2)
+  {
+    set_comb<uint16_t, uint16_t>(deflt, base, check, next);
+  }
+  else if (width == 2)
+  {
+    set_comb<uint16_t, uint32_t>(deflt, base, check, next);
+  }
+  else
+  {
+    set_comb<uint32_t, uint32_t>(deflt, base, check, next);
+  }
+
+  if (matcher.get_unanchored() != nullptr)
+  {
+    unanchored = std::make_unique<const Comb_Matcher>(
+        *matcher.get_unanchored());
+  }
+}
+
+template <typename State_T, typename Base_T>
+void Comb_Matcher::set_comb(const vector<uint32_t>& deflt,
+    const vector<uint32_t>& base, const vector<uint32_t>& check,
+    const vector<uint32_t>& next)
+{
+  Comb<State_T, Base_T> comb;
+  comb.deflt.assign(deflt.begin(), deflt.end());
+  comb.base.assign(base.begin(), base.end());
+  comb.next.assign(next.begin(), next.end());
+
+  // FREE narrows to the largest State_T
+  comb.check.assign(check.begin(), check.end());
+  tables = std::move(comb);
+}
+
+template <typename State_T>
+void Comb_Matcher::set_dense(const vector<uint32_t>& table)
+{
+  Dense<State_T> dense;
+  dense.table.assign(table.begin(), table.end());
+  dense.class_count = class_count;
+  tables = std::move(dense);
+}
+
+template <typename Table>
+bool Comb_Matcher::accept(const Table& table, string_view input) const
+{
+  uint32_t state {start_state};
+
+  for (unsigned char c : input)
+  {
+    state = table.delta(state, byte_class[c]);
+    if (state == DFA_Matcher::DEAD)
+    {
+      return false;
+    }
+  }
+
+  return accepting[state];
+}
+
+template <typename Table>
+size_t Comb_Matcher::first_accept(const Table& table, string_view input)
+  const
+{
+  uint32_t state {start_state};
+  if (accepting[state])
+  {
+    return 0;
+  }
+
+  for (size_t i {0}; i < input.size(); i++)
+  {
+    state = table.delta(state, byte_class[static_cast<uint8_t>(input[i])]);
+    if (accepting[state])
+      return i + 1;
+
+    if (state == DFA_Matcher::DEAD)
+      break;
+  }
+
+  return string_view::npos;
+}
+
+template <typename Table>
+size_t Comb_Matcher::simulate_search(const Table& table, string_view input)
+  const
+{
+  if (accepting[start_state])
+  {
+    return 0;
+  }
+
+  // A state is in next iff its mark is the offset after the byte
+  vector<uint32_t> current {start_state};
+  vector<uint32_t> next;
+  vector<size_t> mark(size(), 0);
+
+  for (size_t i {0}; i < input.size(); i++)
+  {
+    next.assign({start_state});
+    mark[start_state] = i + 1;
+
+    uint8_t cls {byte_class[static_cast<uint8_t>(input[i])]};
+    for (auto state : current)
+    {
+      uint32_t dst {table.delta(state, cls)};
+      if (accepting[dst])
+        return i + 1;
+
+      if (dst != DFA_Matcher::DEAD && mark[dst] != i + 1)
+      {
+        mark[dst] = i + 1;
+        next.push_back(dst);
+      }
+    }
+
+    current.swap(next);
+  }
+
+  return string_view::npos;
+}
+
+bool Comb_Matcher::accept(string_view input) const
+{
+  return std::visit([&](auto& table)
+  {
+    return accept(table, input);
+  }, tables);
+}
+
+bool Comb_Matcher::search(string_view input) const
+{
+  if (unanchored == nullptr)
+  {
+    return std::visit([&](auto& table)
+    {
+      return simulate_search(table, input);
+    }, tables) != string_view::npos;
+  }
+
+  // Stop at the first accepting state
+  return std::visit([&](auto& table)
+  {
+    return unanchored->first_accept(table, input);
+  }, unanchored->tables) != string_view::npos;
+}
+
+size_t Comb_Matcher::memory_usage() const
+{
+  return sizeof(byte_class) + std::visit([](auto& table)
+  {
+    return table.memory_usage();
+  }, tables) + accepting.size() * sizeof(accepting[0]) +
+    (unanchored != nullptr ? unanchored->memory_usage() : 0);
+}
@@ -0,0 +1,192 @@
+#ifndef COMB_MATCHER_H
+#define COMB_MATCHER_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "DFA_Matcher.h"
+
+/*
+ * A matcher with a compressed transition table, for hosting many large
+ * DFAs at once.
+ *
+ * Each state has a default transition, the most common destination in its
+ * row of the DFA_Matcher table, and only the other entries (exceptions)
+ * are stored. The rows of exceptions are packed into a single comb vector
+ * by row displacement ("Engineering a Compiler", section 2.5): row s
+ * starts at base[s], and may interleave with other rows as long as no two
+ * rows use the same slot. check records which row owns each slot, so
+ * lookup is still constant time:
+ *
+ *   delta(s, c) = check[base[s] + c] == s ? next[base[s] + c] : deflt[s]
+ *
+ * Entries are as narrow as the state count allows, 1, 2 or 4 bytes, and
+ * base takes 2 bytes when the comb vector is short enough. A DFA whose
+ * comb would be no smaller than its plain table, as dense rows make it,
+ * keeps the plain table instead. The matching loops pick the form once
+ * per call.
+ *
+ * search() runs the compressed unanchored matcher of the DFA_Matcher in a
+ * single pass (see DFA_Matcher::search).
+ *
+ * Like DFA_Matcher, it is immutable and can be shared by threads.
+ */
+class Comb_Matcher
+{
+  private:
+
+    // The equivalence class of each byte, as in the DFA_Matcher
+    std::array<uint8_t, 256> byte_class;
+
+    unsigned class_count;
+
+    /*
+     * The compressed table, with State_T states and Base_T row offsets.
+     * Slots no row uses are owned by the largest State_T, which is not a
+     * state.
+     */
+    template <typename State_T, typename Base_T>
+    class Comb
+    {
+      public:
+
+        // Default transition and offset of the row of each state
+        std::vector<State_T> deflt;
+        std::vector<Base_T> base;
+
+        // The comb vector: the owner and destination of each slot
+        std::vector<State_T> check;
+        std::vector<State_T> next;
+
+        uint32_t delta(uint32_t state, uint8_t cls) const
+        {
+          auto i {base[state] + cls};
+          return check[i] == state ? next[i] : deflt[state];
+        }
+
+        size_t memory_usage() const
+        {
+          return (deflt.size() + check.size() + next.size()) *
+            sizeof(State_T) + base.size() * sizeof(Base_T);
+        }
+    };
+
+    /*
+     * The plain table, indexed by state * class_count + class
+     */
+    template <typename State_T>
+    class Dense
+    {
+      public:
+        std::vector<State_T> table;
+        unsigned class_count;
+
+        uint32_t delta(uint32_t state, uint8_t cls) const
+        {
+          return table[state * class_count + cls];
+        }
+
+        size_t memory_usage() const
+        {
+          return table.size() * sizeof(State_T);
+        }
+    };
+
+    std::variant<Comb<uint8_t, uint16_t>, Comb<uint16_t, uint16_t>,
+      Comb<uint16_t, uint32_t>, Comb<uint32_t, uint32_t>, Dense<uint8_t>,
+      Dense<uint16_t>, Dense<uint32_t>> tables;
+
+    // accepting[s] != 0 iff s is an accepting state
+    std::vector<uint8_t> accepting;
+
+    uint32_t start_state;
+
+    // The compressed unanchored matcher, null if the matcher has none
+    std::unique_ptr<const Comb_Matcher> unanchored;
+
+    /*
+     * Stores the comb built with 32 bit entries in the given widths
+     */
+    template <typename State_T, typename Base_T>
+    void set_comb(const std::vector<uint32_t>& deflt,
+        const std::vector<uint32_t>& base, const std::vector<uint32_t>& check,
+        const std::vector<uint32_t>& next);
+
+    /*
+     * Stores the plain table, given with 32 bit entries
+     */
+    template <typename State_T>
+    void set_dense(const std::vector<uint32_t>& table);
+
+    /*
+     * The matching loops over each form of the tables. The public
+     * functions pick one per call, not per byte.
+     */
+    template <typename Table>
+    bool accept(const Table& table, std::string_view input) const;
+
+    template <typename Table>
+    size_t first_accept(const Table& table, std::string_view input) const;
+
+    /*
+     * Returns the end of the earliest ending match in the input, or
+     * std::string_view::npos, tracking the states of the matches started
+     * so far
+     */
+    template <typename Table>
+    size_t simulate_search(const Table& table, std::string_view input) const;
+
+  public:
+
+    /*
+     * Compresses the tables of a matcher. State numbers are the same.
+     */
+    Comb_Matcher(const DFA_Matcher& matcher);
+
+    /*
+     * The matcher's transition function. It picks the form of the tables
+     * on every call.
+     */
+    uint32_t delta(uint32_t state, unsigned char c) const
+    {
+      return std::visit([&](auto& table)
+      {
+        return table.delta(state, byte_class[c]);
+      }, tables);
+    }
+
+    /*
+     * Returns true iff the tables are compressed, false if the comb would
+     * have been no smaller than the plain table
+     */
+    bool is_compressed() const { return tables.index() < 4; }
+
+    /*
+     * Returns true iff the matcher recognizes the whole input
+     */
+    bool accept(std::string_view input) const;
+
+    /*
+     * Returns true iff the matcher recognizes some substring of the input
+     */
+    bool search(std::string_view input) const;
+
+    uint32_t get_start_state() const { return start_state; }
+    bool is_accepting(uint32_t state) const { return accepting[state]; }
+
+    /*
+     * Returns the number of states, including the dead state
+     */
+    size_t size() const { return accepting.size(); }
+
+    /*
+     * Returns the number of bytes used by the matcher's tables
+     */
+    size_t memory_usage() const;
+};
+
+#endif
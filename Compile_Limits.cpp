@@ -0,0 +1,81 @@
+/*
+ * Compile_Limits implementation file
+ */
+
+#include <chrono>
+#include <string>
+
+#include "Compile_Limits.h"
+
+using namespace std;
+
+// Characters per row of the transition table
+static const size_t ALPHABET_SIZE {'~' - ' ' + 1};
+
+static string describe(Compile_Limit_Error::Reason reason, size_t states)
+{
+  string msg;
+  switch (reason)
+  {
+    case Compile_Limit_Error::Reason::STATES:
+      msg = "DFA state limit reached";
+      break;
+
+    case Compile_Limit_Error::Reason::TABLE_BYTES:
+      msg = "DFA table size limit reached";
+      break;
+
+    case Compile_Limit_Error::Reason::TIME:
+      msg = "Compile time limit reached";
+      break;
+
+    case Compile_Limit_Error::Reason::CANCELLED:
+      msg = "Compilation cancelled";
+      break;
+  }
+
+  return msg + " after " + to_string(states) + " states";
+}
+
+Compile_Limit_Error::Compile_Limit_Error(Reason r, size_t states) :
+  runtime_error(describe(r, states)), limit_reason(r), state_count(states)
+{
+}
+
+Compile_Budget::Compile_Budget(const Compile_Limits& compile_limits) :
+  limits(compile_limits)
+{
+  auto now {chrono::steady_clock::now()};
+
+  // Saturate instead of overflowing the clock
+  if (limits.max_time >= chrono::steady_clock::time_point::max() - now)
+    deadline = chrono::steady_clock::time_point::max();
+  else
+    deadline = now + limits.max_time;
+}
+
+void Compile_Budget::check(size_t states) const
+{
+  typedef Compile_Limit_Error::Reason Reason;
+
+  if (limits.token != nullptr && limits.token->is_cancelled())
+  {
+    throw Compile_Limit_Error(Reason::CANCELLED, states);
+  }
+
+  if (states > limits.max_states)
+  {
+    throw Compile_Limit_Error(Reason::STATES, states);
+  }
+
+  // Size of the dense table the matcher would need
+  if (states > limits.max_table_bytes / (ALPHABET_SIZE * sizeof(uint32_t)))
+  {
+    throw Compile_Limit_Error(Reason::TABLE_BYTES, states);
+  }
+
+  if (chrono::steady_clock::now() > deadline)
+  {
+    throw Compile_Limit_Error(Reason::TIME, states);
+  }
+}
@@ -0,0 +1,103 @@
+#ifndef COMPILE_LIMITS_H
+#define COMPILE_LIMITS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+/*
+ * A flag another thread can set to stop a compilation
+ */
+class Cancellation_Token
+{
+  private:
+    std::atomic<bool> cancelled {false};
+
+  public:
+    void cancel() { cancelled = true; }
+    bool is_cancelled() const { return cancelled; }
+};
+
+/*
+ * Limits on the resources a single DFA compilation may use.
+ * The defaults are unlimited.
+ */
+class Compile_Limits
+{
+  public:
+
+    // Maximum number of DFA states
+    size_t max_states {std::numeric_limits<size_t>::max()};
+
+    // Maximum size of the DFA's transition table, in bytes
+    size_t max_table_bytes {std::numeric_limits<size_t>::max()};
+
+    // Maximum wall time
+    std::chrono::steady_clock::duration max_time {
+      std::chrono::steady_clock::duration::max()};
+
+    // Stops the compilation when cancelled, if not null
+    const Cancellation_Token* token {nullptr};
+};
+
+/*
+ * Thrown when a compilation reaches one of its limits
+ */
+class Compile_Limit_Error : public std::runtime_error
+{
+  public:
+    enum class Reason
+    {
+      STATES,
+      TABLE_BYTES,
+      TIME,
+      CANCELLED
+    };
+
+    Compile_Limit_Error(Reason r, size_t states);
+
+    Reason reason() const { return limit_reason; }
+
+    /*
+     * Returns the number of DFA states built when the limit was reached
+     */
+    size_t states() const { return state_count; }
+
+    /*
+     * Returns true iff the pattern is valid but too expensive for a DFA,
+     * so the caller should match it with a non-DFA engine (NFA::accept)
+     */
+    bool use_nfa() const { return limit_reason != Reason::CANCELLED; }
+
+  private:
+    Reason limit_reason;
+    size_t state_count;
+};
+
+/*
+ * Tracks a compilation against its limits
+ */
+class Compile_Budget
+{
+  private:
+    const Compile_Limits& limits;
+
+    std::chrono::steady_clock::time_point deadline;
+
+  public:
+
+    /*
+     * Starts the compilation clock
+     */
+    Compile_Budget(const Compile_Limits& compile_limits);
+
+    /*
+     * Throws Compile_Limit_Error if a DFA with the given number of states
+     * is over the limits, time is up or the compilation was cancelled
+     */
+    void check(size_t states) const;
+};
+
+#endif
@@ -0,0 +1,847 @@
+#ifndef CONSTEXPR_REGEX_H
+#define CONSTEXPR_REGEX_H
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/*
+ * A string literal usable as a template argument
+ */
+template <size_t N>
+class Fixed_String
+{
+  public:
+    char data[N] {};
+
+    constexpr Fixed_String(const char (&str)[N])
+    {
+      for (size_t i {0}; i < N; i++)
+      {
+        data[i] = str[i];
+      }
+    }
+
+    /*
+     * Returns the length of the string, without the terminating null
+     */
+    constexpr size_t size() const { return N - 1; }
+};
+
+/*
+ * A table matcher built at compile time by Constexpr_Regex::compile.
+ * The layout is the same as DFA_Matcher's, with the table sized exactly
+ * and its entries State_T wide. State 0 is the dead state.
+ */
+template <typename State_T, size_t STATES, size_t CLASSES>
+class Constexpr_Matcher
+{
+  private:
+    friend class Constexpr_Regex;
+
+    // The equivalence class of each byte
+    std::array<uint8_t, 256> byte_class {};
+
+    // Transition table, indexed by state * CLASSES + class
+    std::array<State_T, STATES * CLASSES> table {};
+
+    std::array<bool, STATES> accepting {};
+
+    State_T start_state {0};
+
+  public:
+
+    static constexpr State_T DEAD {0};
+
+    /*
+     * The matcher's transition function
+     */
+    constexpr State_T delta(State_T state, unsigned char c) const
+    {
+      return table[state * CLASSES + byte_class[c]];
+    }
+
+    /*
+     * Returns true iff the matcher recognizes the whole input
+     */
+    constexpr bool accept(std::string_view input) const
+    {
+      State_T state {start_state};
+      for (unsigned char c : input)
+      {
+        state = delta(state, c);
+        if (state == DEAD)
+        {
+          return false;
+        }
+      }
+
+      return accepting[state];
+    }
+
+    constexpr State_T get_start_state() const { return start_state; }
+    constexpr bool is_accepting(State_T state) const
+    {
+      return accepting[state];
+    }
+
+    /*
+     * Returns the number of states, including the dead state
+     */
+    constexpr size_t size() const { return STATES; }
+
+    /*
+     * Returns the number of byte equivalence classes
+     */
+    constexpr size_t get_class_count() const { return CLASSES; }
+};
+
+/*
+ * A class that runs the parse -> NFA -> DFA -> minimize pipeline during
+ * compilation, for patterns known at build time:
+ *
+ *   static constexpr auto matcher {Constexpr_Regex::compile<"[a-z]*">()};
+ *
+ * The syntax is the same as Regex_Parser's, and an invalid pattern is a
+ * compile error at the throw describing it. The intermediate automata
+ * live in transient std::vectors; only the minimized tables are kept, in
+ * a Constexpr_Matcher whose state index is the narrowest that fits.
+ */
+class Constexpr_Regex
+{
+  private:
+
+    static constexpr char ALPHABET_START {' '};
+    static constexpr char ALPHABET_END {'~'};
+
+    // Subset construction gives up past this many DFA states
+    static constexpr size_t MAX_DFA_STATES {4096};
+    static constexpr size_t HASH_BUCKETS {127};
+    static constexpr size_t NONE {~size_t {0}};
+
+    /*
+     * A set of ASCII characters
+     */
+    class Set
+    {
+      public:
+        uint64_t bits[2] {0, 0};
+
+        constexpr void set(size_t c)
+        {
+          bits[c / 64] |= uint64_t {1} << (c % 64);
+        }
+
+        constexpr bool test(size_t c) const
+        {
+          return bits[c / 64] >> (c % 64) & 1;
+        }
+
+        constexpr bool operator!=(const Set& other) const
+        {
+          return bits[0] != other.bits[0] || bits[1] != other.bits[1];
+        }
+    };
+
+    /*
+     * A Thompson NFA state: a transition over chars to next, and up to
+     * two epsilon transitions. -1 is no transition.
+     */
+    class NFA_State
+    {
+      public:
+        Set chars;
+        int next {-1};
+        int epsilon[2] {-1, -1};
+    };
+
+    // An NFA fragment with one entry and one exit state
+    class Fragment
+    {
+      public:
+        int start;
+        int end;
+    };
+
+    /*
+     * Recursive descent parser for Regex_Parser's grammar, building the
+     * NFA as it goes
+     */
+    class Parser
+    {
+      public:
+        std::vector<char> input;
+        size_t parse_location {0};
+        std::vector<NFA_State> states;
+
+        constexpr Parser(const char* regex, size_t length)
+        {
+          // Blanks are ignored, as in Regex_Parser::normalize
+          for (size_t i {0}; i < length; i++)
+          {
+            if (regex[i] != ' ')
+              input.push_back(regex[i]);
+          }
+
+          input.push_back('\0');
+        }
+
+        constexpr char peek() const { return input[parse_location]; }
+
+        constexpr int add_state()
+        {
+          states.push_back(NFA_State());
+          return states.size() - 1;
+        }
+
+        constexpr void add_epsilon(int from, int to)
+        {
+          auto& epsilon {states[from].epsilon};
+          epsilon[epsilon[0] == -1 ? 0 : 1] = to;
+        }
+
+        static constexpr bool is_special(char c)
+        {
+          return c == '(' || c == ')' || c == '[' ||
+            c == ']' || c == '*' || c == '|' || c == '\\';
+        }
+
+        constexpr Fragment goal()
+        {
+          auto ret {expr()};
+          if (parse_location < input.size() - 1)
+          {
+            throw std::runtime_error("Invalid character");
+          }
+
+          return ret;
+        }
+
+        // Expr -> Term | Term | ...
+        constexpr Fragment expr()
+        {
+          auto node {term()};
+          while (peek() == '|')
+          {
+            parse_location++;
+            auto operand {term()};
+
+            Fragment alt {add_state(), add_state()};
+            add_epsilon(alt.start, node.start);
+            add_epsilon(alt.start, operand.start);
+            add_epsilon(node.end, alt.end);
+            add_epsilon(operand.end, alt.end);
+            node = alt;
+          }
+
+          return node;
+        }
+
+        // Term -> closure closure ...
+        constexpr Fragment term()
+        {
+          auto node {closure()};
+          while (true)
+          {
+            char c {peek()};
+            if (c == '(' || c == '[' || c == '\\' ||
+                (c >= ALPHABET_START && c <= ALPHABET_END && !is_special(c)))
+            {
+              auto operand {closure()};
+              add_epsilon(node.end, operand.start);
+              node.end = operand.end;
+            }
+            else if (c == '|' || c == '\0' || c == ')')
+            {
+              return node;
+            }
+            else
+            {
+              throw std::runtime_error("Invalid character");
+            }
+          }
+        }
+
+        // closure -> Factor | Factor*
+        constexpr Fragment closure()
+        {
+          auto node {factor()};
+          if (peek() == '*')
+          {
+            parse_location++;
+
+            Fragment star {add_state(), add_state()};
+            add_epsilon(star.start, node.start);
+            add_epsilon(star.start, star.end);
+            add_epsilon(node.end, node.start);
+            add_epsilon(node.end, star.end);
+            node = star;
+          }
+
+          return node;
+        }
+
+        // Factor -> (Expr) | character | bracket
+        constexpr Fragment factor()
+        {
+          Set chars;
+          char c {peek()};
+
+          if (c == '(')
+          {
+            parse_location++;
+            auto ret {expr()};
+            if (peek() != ')')
+            {
+              throw std::runtime_error("Expected closing ')'");
+            }
+
+            parse_location++;
+            return ret;
+          }
+          else if (c == '[')
+          {
+            parse_location++;
+            chars = bracket();
+          }
+          else
+          {
+            chars.set(character());
+          }
+
+          Fragment ret {add_state(), add_state()};
+          states[ret.start].chars = chars;
+          states[ret.start].next = ret.end;
+          return ret;
+        }
+
+        constexpr char character()
+        {
+          char c {peek()};
+          if (c == '\\')
+          {
+            parse_location++;
+            c = peek();
+            if (c == 's')
+            {
+              c = ' ';
+            }
+            else if (!is_special(c))
+            {
+              throw std::runtime_error("Invalid escape character");
+            }
+          }
+          else if (c < ALPHABET_START || c > ALPHABET_END || is_special(c))
+          {
+            throw std::runtime_error("Invalid character");
+          }
+
+          parse_location++;
+          return c;
+        }
+
+        constexpr void add_range(Set& set, char start, char end)
+        {
+          for (char c {start}; c <= end; c++)
+          {
+            set.set(c);
+          }
+        }
+
+        // bracket -> element_list] | ^element_list]
+        constexpr Set bracket()
+        {
+          Set set;
+          bool complement {peek() == '^'};
+          if (complement)
+          {
+            parse_location++;
+          }
+
+          // A leading ] is literal, and may start a range
+          if (peek() == ']')
+          {
+            parse_location++;
+            char end {']'};
+            if (peek() == '-')
+            {
+              parse_location++;
+              end = peek();
+              if (end < ']' || end > ALPHABET_END)
+              {
+                throw std::runtime_error("Invalid range");
+              }
+            }
+
+            add_range(set, ']', end);
+          }
+          else
+          {
+            element(set);
+          }
+
+          while (peek() != ']')
+          {
+            element(set);
+          }
+
+          parse_location++;
+          if (complement)
+          {
+            for (auto& word : set.bits)
+            {
+              word = ~word;
+            }
+          }
+
+          Set ret;
+          for (char c {ALPHABET_START}; c <= ALPHABET_END; c++)
+          {
+            if (set.test(c))
+              ret.set(c);
+          }
+
+          return ret;
+        }
+
+        // element -> ascii | ascii-ascii | -]
+        constexpr void element(Set& set)
+        {
+          char c {peek()};
+          if (c >= ALPHABET_START && c <= ALPHABET_END && c != '-' && c != ']')
+          {
+            parse_location++;
+            char end {c};
+            if (peek() == '-')
+            {
+              parse_location++;
+              end = peek();
+              parse_location++;
+
+              if (end == '-' && peek() != ']')
+              {
+                throw std::runtime_error(
+                    "Invalid '-' placement in bracket expression");
+              }
+              else if (end < c || end > ALPHABET_END || end == ']')
+              {
+                throw std::runtime_error("Invalid range");
+              }
+            }
+
+            add_range(set, c, end);
+          }
+          else if (c == '-' && input[parse_location + 1] == ']')
+          {
+            parse_location++;
+            set.set('-');
+          }
+          else if (c == '-')
+          {
+            throw std::runtime_error(
+                "Invalid '-' placement in bracket expression");
+          }
+          else
+          {
+            throw std::runtime_error("Expected bracket element");
+          }
+        }
+    };
+
+    /*
+     * A complete DFA over character classes. State 0 is the dead state.
+     */
+    class Table
+    {
+      public:
+        size_t states {0};
+        size_t classes {0};
+        size_t start {0};
+
+        // Indexed by state * classes + class
+        std::vector<uint32_t> delta;
+        std::vector<uint8_t> accepting;
+
+        // The class of each byte
+        std::vector<uint8_t> byte_class;
+    };
+
+    // The size of a minimized table
+    class Shape
+    {
+      public:
+        size_t states;
+        size_t classes;
+    };
+
+    /*
+     * Adds the epsilon closure of state to set
+     */
+    template <typename NFA_Set>
+    static constexpr void closure(const std::vector<NFA_State>& nfa, int state,
+        NFA_Set& set)
+    {
+      if (set[state / 64] >> (state % 64) & 1)
+      {
+        return;
+      }
+
+      set[state / 64] |= uint64_t {1} << (state % 64);
+      for (int e : nfa[state].epsilon)
+      {
+        if (e != -1)
+          closure(nfa, e, set);
+      }
+    }
+
+    /*
+     * Returns the index of value in values, appending it if missing
+     */
+    template <typename T>
+    static constexpr size_t intern(std::vector<T>& values, const T& value)
+    {
+      size_t i {0};
+      while (i < values.size() && values[i] != value)
+      {
+        i++;
+      }
+
+      if (i == values.size())
+        values.push_back(value);
+
+      return i;
+    }
+
+    /*
+     * Subset construction over NFA state sets of WORDS words. Characters
+     * in the same transition sets of the NFA share a class.
+     */
+    template <size_t WORDS>
+    static constexpr Table subset(const std::vector<NFA_State>& nfa,
+        Fragment fragment)
+    {
+      typedef std::array<uint64_t, WORDS> NFA_Set;
+
+      Table dfa;
+      dfa.byte_class.assign(256, 0);
+
+      // The distinct character sets of the NFA's transitions
+      std::vector<Set> char_sets;
+      for (auto& state : nfa)
+      {
+        if (state.next != -1)
+          intern(char_sets, state.chars);
+      }
+
+      // Class 0 is in no set, and holds the bytes outside the alphabet
+      std::vector<Set> signatures {Set()};
+      std::vector<char> representative {'\0'};
+      for (char c {ALPHABET_START}; c <= ALPHABET_END; c++)
+      {
+        if (char_sets.size() > 128)
+        {
+          throw std::runtime_error("Too many character sets");
+        }
+
+        Set signature;
+        for (size_t i {0}; i < char_sets.size(); i++)
+        {
+          if (char_sets[i].test(c))
+            signature.set(i);
+        }
+
+        size_t cls {intern(signatures, signature)};
+        if (cls == representative.size())
+          representative.push_back(c);
+
+        dfa.byte_class[c] = cls;
+      }
+
+      dfa.classes = signatures.size();
+      dfa.start = 1;
+
+      // The closure of each NFA state, and the NFA moves over each class
+      std::vector<NFA_Set> closures(nfa.size());
+      for (size_t s {0}; s < nfa.size(); s++)
+      {
+        closure(nfa, s, closures[s]);
+      }
+
+      // The classes each NFA state moves on are moves[moves_begin[s]..]
+      std::vector<size_t> moves;
+      std::vector<size_t> moves_begin;
+      NFA_Set movers {};
+      for (size_t s {0}; s < nfa.size(); s++)
+      {
+        moves_begin.push_back(moves.size());
+        for (size_t cls {1}; cls < dfa.classes; cls++)
+        {
+          if (nfa[s].chars.test(representative[cls]))
+          {
+            moves.push_back(cls);
+            movers[s / 64] |= uint64_t {1} << (s % 64);
+          }
+        }
+      }
+
+      moves_begin.push_back(moves.size());
+
+      // DFA states are chained by the hash of their NFA state set
+      std::vector<NFA_Set> sets;
+      std::vector<size_t> head(HASH_BUCKETS, NONE);
+      std::vector<size_t> chain;
+      auto find = [&](const NFA_Set& set)
+      {
+        uint64_t hash {0};
+        for (auto word : set)
+        {
+          hash = (hash ^ word) * 0x100000001b3;
+        }
+
+        auto& bucket {head[hash % HASH_BUCKETS]};
+        for (size_t state {bucket}; state != NONE; state = chain[state])
+        {
+          if (sets[state] == set)
+            return state;
+        }
+
+        if (sets.size() == MAX_DFA_STATES)
+        {
+          throw std::runtime_error("Too many DFA states");
+        }
+
+        sets.push_back(set);
+        chain.push_back(bucket);
+        bucket = sets.size() - 1;
+        return bucket;
+      };
+
+      find(NFA_Set {});
+      find(closures[fragment.start]);
+
+      std::vector<NFA_Set> targets(dfa.classes);
+      for (size_t state {0}; state < sets.size(); state++)
+      {
+        dfa.accepting.push_back(
+            sets[state][fragment.end / 64] >> (fragment.end % 64) & 1);
+
+        // Move every NFA state of the set that has a transition
+        targets.assign(dfa.classes, NFA_Set {});
+        for (size_t w {0}; w < WORDS; w++)
+        {
+          for (auto word {sets[state][w] & movers[w]}; word; word &= word - 1)
+          {
+            size_t s {w * 64 + std::countr_zero(word)};
+            auto& closure {closures[nfa[s].next]};
+            for (size_t m {moves_begin[s]}; m < moves_begin[s + 1]; m++)
+            {
+              auto& target {targets[moves[m]]};
+              for (size_t i {0}; i < WORDS; i++)
+              {
+                target[i] |= closure[i];
+              }
+            }
+          }
+        }
+
+        dfa.delta.push_back(0);
+        for (size_t cls {1}; cls < dfa.classes; cls++)
+        {
+          dfa.delta.push_back(find(targets[cls]));
+        }
+      }
+
+      dfa.states = sets.size();
+      return dfa;
+    }
+
+    /*
+     * Moore's partition refinement. Classes with identical columns in the
+     * minimized table are merged.
+     */
+    static constexpr Table minimize(const Table& dfa)
+    {
+      // Start from accepting and non accepting blocks
+      std::vector<size_t> block(dfa.states);
+      size_t blocks {0};
+      for (size_t s {0}; s < dfa.states; s++)
+      {
+        block[s] = dfa.accepting[s];
+      }
+
+      // Two states stay in the same block iff their blocks and the blocks
+      // of their successors are the same
+      auto same = [&](size_t a, size_t b)
+      {
+        if (block[a] != block[b])
+          return false;
+
+        for (size_t c {0}; c < dfa.classes; c++)
+        {
+          if (block[dfa.delta[a * dfa.classes + c]] !=
+              block[dfa.delta[b * dfa.classes + c]])
+            return false;
+        }
+
+        return true;
+      };
+
+      std::vector<size_t> next(dfa.states);
+      std::vector<size_t> first;
+      std::vector<size_t> head(HASH_BUCKETS);
+      std::vector<size_t> chain;
+      while (true)
+      {
+        // Number the new blocks through a hash of the states' signatures.
+        // first[b] is the first state of new block b.
+        first.clear();
+        chain.clear();
+        head.assign(HASH_BUCKETS, NONE);
+        for (size_t s {0}; s < dfa.states; s++)
+        {
+          uint64_t hash {block[s]};
+          for (size_t c {0}; c < dfa.classes; c++)
+          {
+            hash = (hash ^ block[dfa.delta[s * dfa.classes + c]]) *
+              0x100000001b3;
+          }
+
+          auto& bucket {head[hash % HASH_BUCKETS]};
+          size_t b {bucket};
+          while (b != NONE && !same(first[b], s))
+          {
+            b = chain[b];
+          }
+
+          if (b == NONE)
+          {
+            first.push_back(s);
+            chain.push_back(bucket);
+            b = bucket = first.size() - 1;
+          }
+
+          next[s] = b;
+        }
+
+        block.swap(next);
+        if (first.size() == blocks)
+          break;
+
+        blocks = first.size();
+      }
+
+      // Number the blocks: dead first, then start, then the others
+      std::vector<size_t> id(blocks, NONE);
+      size_t ids {0};
+      id[block[0]] = ids++;
+      if (id[block[dfa.start]] == NONE)
+        id[block[dfa.start]] = ids++;
+
+      for (size_t s {0}; s < dfa.states; s++)
+      {
+        if (id[block[s]] == NONE)
+          id[block[s]] = ids++;
+      }
+
+      // One column of destinations per class
+      std::vector<std::vector<uint32_t>> columns(dfa.classes,
+          std::vector<uint32_t>(blocks));
+      std::vector<uint8_t> accepting(blocks);
+      for (size_t s {0}; s < dfa.states; s++)
+      {
+        accepting[id[block[s]]] = dfa.accepting[s];
+        for (size_t c {0}; c < dfa.classes; c++)
+        {
+          columns[c][id[block[s]]] = id[block[dfa.delta[s * dfa.classes + c]]];
+        }
+      }
+
+      // Merge identical columns, class 0 staying dead
+      std::vector<std::vector<uint32_t>> classes;
+      std::vector<size_t> merged(dfa.classes);
+      for (size_t c {0}; c < dfa.classes; c++)
+      {
+        merged[c] = intern(classes, columns[c]);
+      }
+
+      Table ret;
+      ret.states = blocks;
+      ret.classes = classes.size();
+      ret.start = id[block[dfa.start]];
+      ret.accepting = accepting;
+      for (size_t b {0}; b < 256; b++)
+      {
+        ret.byte_class.push_back(merged[dfa.byte_class[b]]);
+      }
+
+      for (size_t s {0}; s < blocks; s++)
+      {
+        for (auto& column : classes)
+        {
+          ret.delta.push_back(column[s]);
+        }
+      }
+
+      return ret;
+    }
+
+    /*
+     * Runs the pipeline over a pattern of length N. Thompson's
+     * construction adds at most two states per character.
+     */
+    template <size_t N>
+    static constexpr Table build(const char* regex)
+    {
+      Parser parser(regex, N);
+      auto fragment {parser.goal()};
+      return minimize(subset<(2 * N + 2 + 63) / 64>(parser.states, fragment));
+    }
+
+    template <Fixed_String PATTERN>
+    static constexpr Shape shape()
+    {
+      auto table {build<PATTERN.size()>(PATTERN.data)};
+      return {table.states, table.classes};
+    }
+
+  public:
+
+    /*
+     * Compiles PATTERN into a matcher during compilation
+     */
+    template <Fixed_String PATTERN>
+    static consteval auto compile()
+    {
+      constexpr Shape SHAPE {shape<PATTERN>()};
+      typedef std::conditional_t<SHAPE.states <= 0x100, uint8_t,
+              std::conditional_t<SHAPE.states <= 0x10000, uint16_t, uint32_t>>
+        State_T;
+
+      auto table {build<PATTERN.size()>(PATTERN.data)};
+      Constexpr_Matcher<State_T, SHAPE.states, SHAPE.classes> matcher;
+      for (size_t c {0}; c < 256; c++)
+      {
+        matcher.byte_class[c] = table.byte_class[c];
+      }
+
+      for (size_t i {0}; i < table.delta.size(); i++)
+      {
+        matcher.table[i] = table.delta[i];
+      }
+
+      for (size_t s {0}; s < table.states; s++)
+      {
+        matcher.accepting[s] = table.accepting[s];
+      }
+
+      matcher.start_state = table.start;
+      return matcher;
+    }
+};
+
+#endif
@@ -2,8 +2,11 @@
  * DFA implementation file
  */
 
+#include <algorithm>
 #include <iostream>
 #include <deque>
+#include <memory_resource>
+#include <utility>
 
 #include "DFA.h"
 #include "NFA.h"
@@ -17,71 +20,183 @@ static const char ALPHABET_END {'~'};
 
 const DFA_State DFA::ERROR {{}};
 
-DFA::DFA(const NFA& nfa)
+DFA::DFA(const NFA& nfa, const Compile_Budget* budget)
 {
-  // "subset construction" algorithm
+  /*
+   * "subset construction" algorithm
+   * DFA states are numbered as they are found, and looked up by their
+   * sorted set of NFA states.
+   */
+  Arena arena;
+  auto memory {arena.resource()};
 
-  // unordered_set representing the dfa's start state
-  auto start_set {nfa.epsilon_closure(nfa.get_start_state_id())};
+  auto hash_set = [](const pmr::vector<unsigned>& set)
+  {
+    size_t ret {0};
+    for (auto x : set)
+    {
+      ret = ret * 31 + std::hash<unsigned>()(x);
+    }
+
+    return ret;
+  };
 
-  start_state = DFA_State(start_set);
+  pmr::unordered_map<pmr::vector<unsigned>, DFA_State, decltype(hash_set)>
+    ids {0, hash_set, memory};
+  pmr::deque<pmr::vector<unsigned>> work_list {memory};
 
-  // add the start state to accepted state set if necessary
-  if (start_set.find(nfa.get_final_state_id()) != start_set.end())
+  // Returns the DFA state for a set of NFA states, adding it if it's new
+  auto add_state = [&](const pmr::unordered_set<unsigned>& nfa_states)
   {
-    accepted_set.emplace(start_set);
-  }
+    pmr::vector<unsigned> set(nfa_states.begin(), nfa_states.end(), memory);
+    sort(set.begin(), set.end());
+
+    auto it {ids.find(set)};
+    if (it != ids.end())
+    {
+      return it->second;
+    }
+
+    DFA_State state({static_cast<unsigned>(ids.size())});
+    ids.emplace(set, state);
+    state_map[state] = {};
+
+    // Add to accepted state set if necessary
+    if (nfa_states.count(nfa.get_final_state_id()) != 0)
+    {
+      accepted_set.emplace(state);
+    }
+
+    work_list.push_back(std::move(set));
+    return state;
+  };
 
-  deque<unordered_set<unsigned>> work_list {start_set};
+  pmr::unordered_set<unsigned> start_set {memory};
+  nfa.epsilon_closure(nfa.get_start_state_id(), start_set);
+  start_state = add_state(start_set);
 
   // Do the subset construction algorithm
+  pmr::unordered_set<unsigned> dst_set {memory};
   while (!work_list.empty())
   {
-    auto curr_dfa_state {work_list.front()};
+    auto curr_set {std::move(work_list.front())};
     work_list.pop_front();
+    DFA_State curr_state {ids.at(curr_set)};
+
+    // Stop before the DFA grows past its budget
+    if (budget != nullptr)
+    {
+      budget->check(ids.size());
+    }
 
     // Add all outgoing transitions for the current dfa state
     for (char c {ALPHABET_START}; c <= ALPHABET_END; c++)
     {
       // Construct the destination state over character c
       // This is the union of epsilon closures of delta(si, c)
-      unordered_set<unsigned> dst_set;
-      for (auto nfa_state : curr_dfa_state)
+      dst_set.clear();
+      for (auto nfa_state : curr_set)
       {
-        if (nfa.delta(nfa_state, c) != NFA::ERROR) 
-        { 
-          for (auto x : nfa.epsilon_closure(nfa.delta(nfa_state, c)))
-          {
-            dst_set.emplace(x);
-          }
+        auto dst {nfa.delta(nfa_state, c)};
+        if (dst != NFA::ERROR)
+        {
+          nfa.epsilon_closure(dst, dst_set);
         }
       }
 
-      DFA_State dst_state(dst_set);
-      if (dst_state != DFA::ERROR)
+      if (!dst_set.empty())
       {
-        // Record the transition
-        state_map[curr_dfa_state].push_front({c, dst_state});
+        DFA_State dst_state {add_state(dst_set)};
+        state_map[curr_state].push_front({c, dst_state});
+      }
+    }
+  }
+}
+
+DFA::DFA(const Position_Automaton& automaton, const Compile_Budget* budget)
+{
+  /*
+   * Subset construction over sets of positions.
+   * The position automaton has no epsilon transitions, so the destination
+   * of a set over c is the union of followpos(p) for its positions p
+   * matching c.
+   */
+  Arena arena;
+  auto memory {arena.resource()};
+
+  pmr::unordered_map<Position_Set, DFA_State> ids {memory};
+  pmr::deque<Position_Set> work_list {memory};
+
+  // Returns the DFA state for a set of positions, adding it if it's new
+  auto add_state = [&](const Position_Set& set)
+  {
+    auto it {ids.find(set)};
+    if (it != ids.end())
+    {
+      return it->second;
+    }
+
+    DFA_State state({static_cast<unsigned>(ids.size())});
+    ids.emplace(set, state);
+    state_map[state] = {};
+
+    // Sets containing the end marker are accepting
+    if (set.test(automaton.get_end_marker()))
+    {
+      accepted_set.emplace(state);
+    }
+
+    work_list.push_back(set);
+    return state;
+  };
 
-        // if we haven't seen it before
-        // Create an entry for and add it to the worklist 
-        if (state_map.find(dst_state) == state_map.end())
+  start_state = add_state(automaton.get_first());
+
+  pmr::vector<Position_Set> dst_sets(ALPHABET_END + 1,
+      Position_Set(automaton.size()), memory);
+
+  while (!work_list.empty())
+  {
+    auto curr_set {std::move(work_list.front())};
+    work_list.pop_front();
+    DFA_State curr_state {ids.at(curr_set)};
+
+    // Stop before the DFA grows past its budget
+    if (budget != nullptr)
+    {
+      budget->check(ids.size());
+    }
+
+    for (auto& dst_set : dst_sets)
+    {
+      dst_set.clear();
+    }
+
+    // Distribute each position's followpos over the characters it matches
+    curr_set.for_each([&](size_t p)
+    {
+      const auto& chars {automaton.get_chars(p)};
+      for (char c {ALPHABET_START}; c <= ALPHABET_END; c++)
+      {
+        if (chars.test(c))
         {
-          work_list.push_back(dst_set);
-          state_map[dst_state] = {};
-          
-          // Add to accepted state set if necessary
-          if (dst_set.find(nfa.get_final_state_id()) != dst_set.end())
-          {
-            accepted_set.emplace(dst_state);
-          }
+          dst_sets[c] |= automaton.get_follow(p);
         }
       }
+    });
+
+    for (char c {ALPHABET_START}; c <= ALPHABET_END; c++)
+    {
+      if (!dst_sets[c].empty())
+      {
+        DFA_State dst_state {add_state(dst_sets[c])};
+        state_map[curr_state].push_front({c, dst_state});
+      }
     }
   }
 }
 
-bool DFA::accept(const string& to_accept)
+bool DFA::accept(const string& to_accept) const
 {
   DFA_State curr_state {start_state};
 
@@ -100,10 +215,11 @@ bool DFA::accept(const string& to_accept)
   return accepted_set.find(curr_state) != accepted_set.end();
 }
 
-void DFA::minimize()
+void DFA::minimize(const Compile_Budget* budget)
 {
   // Do Hopcroft's algorithm and get the resulting set partition
-  auto set_partition {hopcroft()};
+  Arena arena;
+  auto set_partition {hopcroft(arena, budget)};
 
   // Rebuild the DFA
   unordered_map<DFA_State, list<DFA_Transition>> new_state_map;
@@ -123,7 +239,7 @@ void DFA::minimize()
     new_state_map[new_state] = {};
 
     // for all old DFA_States in the set
-    for (auto element : set_partition.at(i))
+    for (auto& element : set_partition.at(i))
     {
       // Add to the new DFA's accepted set if needed
       if (accepted_set.find(element) != accepted_set.end())
@@ -138,7 +254,7 @@ void DFA::minimize()
       }
 
       // Add transitions to the new DFA
-      for (auto t : state_map[element])
+      for (auto& t : state_map[element])
       {
         auto dst_index {get_loc(set_partition, t.dst_node_id) - 
           set_partition.begin()};
@@ -156,20 +272,23 @@ void DFA::minimize()
 
   // Replace all fields
   start_state = new_start;
-  state_map = new_state_map;
-  accepted_set = new_accepted_set;
+  state_map = std::move(new_state_map);
+  accepted_set = std::move(new_accepted_set);
 }
 
-vector<unordered_set<DFA_State>> DFA::hopcroft()
+DFA::Partition DFA::hopcroft(Arena& arena, const Compile_Budget* budget)
 {
+  auto memory {arena.resource()};
+
   /*
    * Initialize the set partition with set of accepting states
    * and set of not accepted states.
    */
-  unordered_set<DFA_State> accepting_states {accepted_set};
-  unordered_set<DFA_State> not_accepting_states;
+  pmr::unordered_set<DFA_State> accepting_states(accepted_set.begin(),
+      accepted_set.end(), 0, memory);
+  pmr::unordered_set<DFA_State> not_accepting_states {memory};
 
-  for (auto p : state_map)
+  for (auto& p : state_map)
   {
     if (accepting_states.find(p.first) == accepting_states.end())
     {
@@ -177,35 +296,38 @@ vector<unordered_set<DFA_State>> DFA::hopcroft()
     }
   }
 
-  vector<unordered_set<DFA_State>> set_partition;
+  Partition set_partition {memory};
 
   // Make sure no subsets are empty (precondition for Hopcroft)
   if (!accepting_states.empty())
   {
-    set_partition.push_back(accepting_states);
+    set_partition.push_back(std::move(accepting_states));
   }
 
   if (!not_accepting_states.empty())
   {
-    set_partition.push_back(not_accepting_states);
+    set_partition.push_back(std::move(not_accepting_states));
   }
 
   // Perform splits until the set partition stops changing
-  vector<unordered_set<DFA_State>> copy;
-  while (set_partition != copy)
+  for (bool changed {true}; changed;)
   {
-    copy = set_partition;
+    if (budget != nullptr)
+    {
+      budget->check(state_map.size());
+    }
+
+    changed = false;
     for (size_t i {0}; i < set_partition.size(); i++)
     {
-      split(set_partition, i);
+      changed |= split(set_partition, i);
     }
   }
 
   return set_partition;
 }
 
-void DFA::split(vector<unordered_set<DFA_State>>& set_partition,
-    size_t element)
+bool DFA::split(Partition& set_partition, size_t element)
 {
   auto& subset {set_partition.at(element)};
   
@@ -231,8 +353,8 @@ void DFA::split(vector<unordered_set<DFA_State>>& set_partition,
       if (new_behavior != behavior)
       {
         // Split the set around c
-        unordered_set<DFA_State> split_set;
-        for (auto x : subset)
+        pmr::unordered_set<DFA_State> split_set {subset.get_allocator()};
+        for (auto& x : subset)
         {
           if (get_loc(set_partition, delta(x, c)) == new_behavior)
           {
@@ -240,21 +362,22 @@ void DFA::split(vector<unordered_set<DFA_State>>& set_partition,
           }
         }
 
-        for (auto x : split_set)
+        for (auto& x : split_set)
         {
           subset.erase(x);
         }
 
         // Add the split set to the set partition
-        set_partition.push_back(split_set);
-        return;
+        set_partition.push_back(std::move(split_set));
+        return true;
       }
     }
   }
+
+  return false;
 }
 
-vector<unordered_set<DFA_State>>::iterator
-  DFA::get_loc(vector<unordered_set<DFA_State>>& set_partition,
+DFA::Partition::iterator DFA::get_loc(Partition& set_partition,
     DFA_State search)
 {
   auto ret {set_partition.begin()};
@@ -267,24 +390,323 @@ vector<unordered_set<DFA_State>>::iterator
   return ret;
 }
 
-DFA_State DFA::delta(DFA_State state, char character)
+DFA DFA::product(const DFA& a, const DFA& b, Operation operation,
+    const Compile_Budget* budget)
 {
-  // Iterate through the state's transition list
-  for (auto t : state_map[state])
+  /*
+   * Number each DFA's states, ERROR being the last, so a pair of states
+   * is a single integer. The pair (ERROR, ERROR) is the product's ERROR.
+   */
+  Arena arena;
+  auto memory {arena.resource()};
+
+  auto number = [&](const DFA& dfa)
   {
-    if (t.character == character)
+    pmr::unordered_map<DFA_State, size_t> ids {memory};
+    for (auto& p : dfa.state_map)
     {
-      return t.dst_node_id;
+      ids.emplace(p.first, ids.size());
+    }
+
+    ids.emplace(DFA::ERROR, ids.size());
+    return ids;
+  };
+
+  auto ids_a {number(a)};
+  auto ids_b {number(b)};
+  size_t error_a {ids_a.at(DFA::ERROR)};
+  size_t error_b {ids_b.at(DFA::ERROR)};
+
+  auto accepts = [&](const DFA_State& sa, const DFA_State& sb)
+  {
+    bool in_a {a.accepted_set.count(sa) != 0};
+    bool in_b {b.accepted_set.count(sb) != 0};
+
+    switch (operation)
+    {
+      case Operation::INTERSECTION:
+        return in_a && in_b;
+      case Operation::UNION:
+        return in_a || in_b;
+      case Operation::DIFFERENCE:
+        return in_a && !in_b;
+    }
+
+    return false;
+  };
+
+  DFA ret;
+  pmr::unordered_map<size_t, DFA_State> states {memory};
+  pmr::deque<pair<DFA_State, DFA_State>> work_list {memory};
+
+  // Returns the product state for a pair, adding it if it's new
+  auto add_state = [&](const DFA_State& sa, const DFA_State& sb)
+  {
+    size_t key {ids_a.at(sa) * (error_b + 1) + ids_b.at(sb)};
+    auto it {states.find(key)};
+    if (it != states.end())
+    {
+      return it->second;
+    }
+
+    DFA_State state({static_cast<unsigned>(states.size())});
+    states.emplace(key, state);
+    ret.state_map[state] = {};
+
+    if (accepts(sa, sb))
+    {
+      ret.accepted_set.emplace(state);
+    }
+
+    work_list.emplace_back(sa, sb);
+    return state;
+  };
+
+  ret.start_state = add_state(a.start_state, b.start_state);
+
+  while (!work_list.empty())
+  {
+    auto [sa, sb] {work_list.front()};
+    work_list.pop_front();
+    DFA_State curr_state {states.at(ids_a.at(sa) * (error_b + 1) +
+        ids_b.at(sb))};
+
+    // Stop before the DFA grows past its budget
+    if (budget != nullptr)
+    {
+      budget->check(states.size());
+    }
+
+    for (char c {ALPHABET_START}; c <= ALPHABET_END; c++)
+    {
+      auto da {a.delta(sa, c)};
+      auto db {b.delta(sb, c)};
+
+      // Pairs that can never accept are left to trim(), except ERROR
+      if (ids_a.at(da) == error_a && ids_b.at(db) == error_b)
+        continue;
+
+      auto dst_state {add_state(da, db)};
+      ret.state_map[curr_state].push_front({c, dst_state});
     }
   }
 
-  return DFA::ERROR;
+  ret.trim();
+  ret.minimize(budget);
+  return ret;
+}
+
+DFA DFA::complement(const DFA& a, const Compile_Budget* budget)
+{
+  // The DFA recognizing every string, minus a
+  DFA all;
+  all.start_state = DFA_State({0});
+  all.accepted_set.emplace(all.start_state);
+  for (char c {ALPHABET_START}; c <= ALPHABET_END; c++)
+  {
+    all.state_map[all.start_state].push_front({c, all.start_state});
+  }
+
+  return product(all, a, Operation::DIFFERENCE, budget);
+}
+
+DFA::Table DFA::tabulate(const DFA& dfa)
+{
+  const size_t alphabet_size {ALPHABET_END - ALPHABET_START + 1};
+
+  unordered_map<DFA_State, uint32_t> ids;
+  for (auto& p : dfa.state_map)
+  {
+    ids.emplace(p.first, ids.size());
+  }
+
+  uint32_t error {static_cast<uint32_t>(ids.size())};
+  ids.emplace(DFA::ERROR, error);
+
+  Table table {vector<uint32_t>((error + 1) * alphabet_size, error),
+    vector<bool>(error + 1), ids.at(dfa.start_state)};
+
+  for (auto& p : dfa.state_map)
+  {
+    auto state {ids.at(p.first)};
+    table.accepting[state] = dfa.accepted_set.count(p.first) != 0;
+
+    for (auto& t : p.second)
+    {
+      table.next[state * alphabet_size + t.character - ALPHABET_START] =
+        ids.at(t.dst_node_id);
+    }
+  }
+
+  return table;
+}
+
+bool DFA::equivalent(const DFA& a, const DFA& b)
+{
+  const size_t alphabet_size {ALPHABET_END - ALPHABET_START + 1};
+  auto ta {tabulate(a)};
+  auto tb {tabulate(b)};
+
+  // Union find over the states of both, b's numbered after a's
+  uint32_t offset {static_cast<uint32_t>(ta.accepting.size())};
+  vector<uint32_t> parent(offset + tb.accepting.size());
+  for (uint32_t i {0}; i < parent.size(); i++)
+  {
+    parent[i] = i;
+  }
+
+  auto find = [&](uint32_t x)
+  {
+    while (parent[x] != x)
+    {
+      parent[x] = parent[parent[x]];
+      x = parent[x];
+    }
+    return x;
+  };
+
+  /*
+   * States reached by the same string must be equivalent. Merge them,
+   * and check the pairs they lead to, until a pair differs on accepting
+   * or every pair reachable together is merged.
+   */
+  vector<pair<uint32_t, uint32_t>> work_list {{ta.start, tb.start}};
+  parent[offset + tb.start] = ta.start;
+
+  while (!work_list.empty())
+  {
+    auto [sa, sb] {work_list.back()};
+    work_list.pop_back();
+
+    if (ta.accepting[sa] != tb.accepting[sb])
+    {
+      return false;
+    }
+
+    for (size_t c {0}; c < alphabet_size; c++)
+    {
+      auto da {ta.next[sa * alphabet_size + c]};
+      auto db {tb.next[sb * alphabet_size + c]};
+      auto ra {find(da)};
+      auto rb {find(offset + db)};
+
+      if (ra != rb)
+      {
+        parent[rb] = ra;
+        work_list.emplace_back(da, db);
+      }
+    }
+  }
+
+  return true;
 }
 
-DFA_State DFA::delta(unordered_map<DFA_State, 
+bool DFA::contained(const DFA& a, const DFA& b)
+{
+  const size_t alphabet_size {ALPHABET_END - ALPHABET_START + 1};
+  auto ta {tabulate(a)};
+  auto tb {tabulate(b)};
+
+  // Search the pairs reachable together for one only a accepts
+  uint64_t b_states {tb.accepting.size()};
+  uint32_t a_error {static_cast<uint32_t>(ta.accepting.size() - 1)};
+  unordered_set<uint64_t> seen {ta.start * b_states + tb.start};
+  vector<pair<uint32_t, uint32_t>> work_list {{ta.start, tb.start}};
+
+  while (!work_list.empty())
+  {
+    auto [sa, sb] {work_list.back()};
+    work_list.pop_back();
+
+    if (ta.accepting[sa] && !tb.accepting[sb])
+    {
+      return false;
+    }
+
+    for (size_t c {0}; c < alphabet_size; c++)
+    {
+      auto da {ta.next[sa * alphabet_size + c]};
+      auto db {tb.next[sb * alphabet_size + c]};
+
+      // Nothing is accepted after a dies
+      if (da != a_error && seen.insert(da * b_states + db).second)
+      {
+        work_list.emplace_back(da, db);
+      }
+    }
+  }
+
+  return true;
+}
+
+void DFA::trim()
+{
+  // Walk the transitions backwards from the accepting states
+  Arena arena;
+  auto memory {arena.resource()};
+
+  pmr::unordered_map<DFA_State, pmr::vector<DFA_State>> predecessors {
+    memory};
+  for (auto& p : state_map)
+  {
+    for (auto& t : p.second)
+    {
+      predecessors[t.dst_node_id].push_back(p.first);
+    }
+  }
+
+  pmr::unordered_set<DFA_State> live(accepted_set.begin(),
+      accepted_set.end(), 0, memory);
+  pmr::deque<DFA_State> work_list(accepted_set.begin(), accepted_set.end(),
+      memory);
+  while (!work_list.empty())
+  {
+    auto state {work_list.front()};
+    work_list.pop_front();
+
+    for (auto& p : predecessors[state])
+    {
+      if (live.insert(p).second)
+      {
+        work_list.push_back(p);
+      }
+    }
+  }
+
+  for (auto it {state_map.begin()}; it != state_map.end();)
+  {
+    // The start state stays, with no transitions if it is dead
+    if (live.count(it->first) == 0 && it->first != start_state)
+    {
+      it = state_map.erase(it);
+      continue;
+    }
+
+    it->second.remove_if([&](const DFA_Transition& t)
+    {
+      return live.count(t.dst_node_id) == 0;
+    });
+    it++;
+  }
+}
+
+DFA_State DFA::delta(DFA_State state, char character) const
+{
+  return delta(state_map, state, character);
+}
+
+DFA_State DFA::delta(const unordered_map<DFA_State, 
     list<DFA_Transition>>& s_map, DFA_State state, char character)
 {
-  for (auto t : s_map[state])
+  // Look the state up without inserting, so concurrent readers are safe
+  auto it {s_map.find(state)};
+  if (it == s_map.end())
+  {
+    return DFA::ERROR;
+  }
+
+  // Iterate through the state's transition list
+  for (auto& t : it->second)
   {
     if (t.character == character)
     {
@@ -296,7 +718,7 @@ DFA_State DFA::delta(unordered_map<DFA_State,
 }
 
 
-void DFA::print()
+void DFA::print() const
 {
   for (auto p : state_map)
   {
@@ -3,17 +3,20 @@
 
 #include <vector>
 #include <list>
+#include <memory_resource>
 #include <unordered_set>
 #include <unordered_map>
 #include <string>
 
 #include "NFA.h"
+#include "Compile_Limits.h"
+#include "Position_Automaton.h"
 #include "DFA_Transition.h"
 #include "DFA_State.h"
 
 /*
  * A class Representing a DFA.
- * Supports minimization and acceptence testing.
+ * Supports minimization, acceptence testing and boolean operations.
  */
 class DFA
 {
@@ -27,40 +30,98 @@ class DFA
     // The DFA's start state
     DFA_State start_state;
 
+    /*
+     * Memory for the temporaries of one construction, minimization or
+     * boolean operation. Freed blocks are pooled for reuse, and the whole
+     * arena is released at once when it goes out of scope, so building a
+     * DFA neither calls the heap per temporary object nor fragments it.
+     */
+    class Arena
+    {
+      private:
+        std::pmr::monotonic_buffer_resource buffer;
+        std::pmr::unsynchronized_pool_resource pool {&buffer};
+
+      public:
+        std::pmr::memory_resource* resource() { return &pool; }
+    };
+
+    // A set partition of the states, allocated from an arena
+    typedef std::pmr::vector<std::pmr::unordered_set<DFA_State>> Partition;
+
     /*
      * Perform Hopcroft's algorithm
      * returns the resulting set partition
      */
-    std::vector<std::unordered_set<DFA_State>> hopcroft();
+    Partition hopcroft(Arena& arena, const Compile_Budget* budget);
     
     /*
      * Checks if all the states in a particular subset have
      * the same behavior in response to all characters in the alphabet.
      * If all the elements in the subset don't have the same behavior,
-     * the subset gets split
+     * the subset gets split. Returns true iff it was split.
      */
-    void split(std::vector<std::unordered_set<DFA_State>>& partition,
-        size_t element);
+    bool split(Partition& partition, size_t element);
     
     /*
      * Returns an iterator pointing to the element containing the value search
      */
-    std::vector<std::unordered_set<DFA_State>>::iterator
-      get_loc(std::vector<std::unordered_set<DFA_State>>& partition,
-        DFA_State search);
+    Partition::iterator get_loc(Partition& partition, DFA_State search);
 
     /*
      * Overload of the delta function that accepts any state map
      */
-    DFA_State delta(std::unordered_map<DFA_State, 
+    static DFA_State delta(const std::unordered_map<DFA_State, 
         std::list<DFA_Transition>>&, DFA_State, char);
+
+    /*
+     * The DFA as a dense table over the alphabet, for comparing DFAs.
+     * State ids are integers, and the last state is ERROR, which loops
+     * on every character.
+     */
+    class Table
+    {
+      public:
+        // Indexed by state * alphabet size + character - alphabet start
+        std::vector<uint32_t> next;
+        std::vector<bool> accepting;
+        uint32_t start;
+    };
+
+    static Table tabulate(const DFA& dfa);
+
+    /*
+     * Constructs an empty DFA, for the boolean operations to fill
+     */
+    DFA() {}
+
+    /*
+     * Removes the states from which no accepting state can be reached,
+     * and the transitions into them
+     */
+    void trim();
+
+    // Give the table matcher access to the states
+    friend class DFA_Matcher;
   
   public:
 
+    /*
+     * Boolean operations on the languages of two DFAs
+     */
+    enum class Operation {INTERSECTION, UNION, DIFFERENCE};
+
     /*
      * Constructs a DFA from an NFA
+     * Throws Compile_Limit_Error if the construction goes over budget
      */
-    DFA(const NFA&);
+    DFA(const NFA&, const Compile_Budget* budget = nullptr);
+
+    /*
+     * Constructs a DFA directly from a regex's position automaton
+     * Throws Compile_Limit_Error if the construction goes over budget
+     */
+    DFA(const Position_Automaton&, const Compile_Budget* budget = nullptr);
     
     /*
      * DFA's transition function
@@ -69,23 +130,59 @@ class DFA
      *
      * returns DFA::ERROR if no transition from x exists over c
      */
-    DFA_State delta(DFA_State, char character);
+    DFA_State delta(DFA_State, char character) const;
     
     /*
      * Minimizes the DFA
+     * Throws Compile_Limit_Error if time is up or the compilation is
+     * cancelled. The DFA is left unchanged in that case.
      */ 
-    void minimize();
+    void minimize(const Compile_Budget* budget = nullptr);
     
+    /*
+     * Returns the minimal DFA recognizing the intersection, union or
+     * difference (a but not b) of the languages of a and b, built by
+     * running both in lockstep over pairs of their states.
+     * Throws Compile_Limit_Error if the construction goes over budget
+     */
+    static DFA product(const DFA& a, const DFA& b, Operation operation,
+        const Compile_Budget* budget = nullptr);
+
+    /*
+     * Returns the minimal DFA recognizing every string over the alphabet
+     * that a does not recognize
+     * Throws Compile_Limit_Error if the construction goes over budget
+     */
+    static DFA complement(const DFA& a,
+        const Compile_Budget* budget = nullptr);
+
+    /*
+     * Returns true iff a and b recognize the same language, by merging
+     * the states the two must reach together (Hopcroft and Karp's union
+     * find algorithm)
+     */
+    static bool equivalent(const DFA& a, const DFA& b);
+
+    /*
+     * Returns true iff every string recognized by a is recognized by b
+     */
+    static bool contained(const DFA& a, const DFA& b);
+
     /*
      * Checks if a given string can be accepted by the DFA
      * returns true iff the DFA recognizes the input string
      */
-    bool accept(const std::string& to_accept);
+    bool accept(const std::string& to_accept) const;
     
+    /*
+     * Returns the number of states
+     */
+    size_t size() const { return state_map.size(); }
+
     /*
      * Print a description of the DFA
      */
-    void print();
+    void print() const;
     
     /*
      * Represents a DFA error state
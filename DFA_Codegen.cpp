@@ -0,0 +1,235 @@
+/*
+ * DFA_Codegen implementation file
+ */
+
+#include <cctype>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "DFA_Codegen.h"
+#include "DFA_Matcher.h"
+
+using namespace std;
+
+static const char ALPHABET_START {' '};
+static const char ALPHABET_END {'~'};
+
+// Number of table entries written per line
+static const int ENTRIES_PER_LINE {16};
+
+/*
+ * Returns the narrowest unsigned type that can hold n distinct values
+ */
+static string index_type(size_t n)
+{
+  if (n <= 0x100)
+    return "std::uint8_t";
+
+  if (n <= 0x10000)
+    return "std::uint16_t";
+
+  return "std::uint32_t";
+}
+
+/*
+ * Returns a C++ literal for character c
+ */
+static string char_literal(char c)
+{
+  if (c == '\'' || c == '\\')
+    return string("'\\") + c + "'";
+
+  if (isprint(static_cast<unsigned char>(c)))
+    return string("'") + c + "'";
+
+  return to_string(static_cast<unsigned char>(c));
+}
+
+/*
+ * Returns a C++ string literal for str
+ */
+static string string_literal(const string& str)
+{
+  string ret {"\""};
+  for (char c : str)
+  {
+    if (c == '"' || c == '\\')
+      ret += '\\';
+
+    ret += c;
+  }
+
+  return ret + "\"";
+}
+
+/*
+ * Writes the elements of values as a braced initializer list
+ */
+template <typename T>
+static void write_array(ostream& out, const vector<T>& values)
+{
+  out << "{";
+  for (size_t i {0}; i < values.size(); i++)
+  {
+    if (i % ENTRIES_PER_LINE == 0)
+      out << "\n  ";
+    else
+      out << " ";
+
+    out << +values[i] << (i + 1 < values.size() ? "," : "");
+  }
+
+  out << "\n};\n\n";
+}
+
+void DFA_Codegen::generate(ostream& out, const DFA_Matcher& matcher,
+    const string& name, const string& pattern, Mode mode)
+{
+  string guard;
+  for (char c : name)
+  {
+    guard += toupper(static_cast<unsigned char>(c));
+  }
+
+  guard += "_H";
+
+  out << "/*\n"
+    << " * Generated by Regex_Codegen. Do not edit.\n"
+    << " * " << matcher.size() - 1 << " states, "
+    << (mode == Mode::TABLE ? "table driven" : "direct coded") << "\n"
+    << " */\n\n"
+    << "#ifndef " << guard << "\n"
+    << "#define " << guard << "\n\n"
+    << "#include <cstdint>\n"
+    << "#include <string_view>\n\n"
+    << "inline constexpr char " << name << "_pattern[] {"
+    << string_literal(pattern) << "};\n\n";
+
+  if (mode == Mode::TABLE)
+    generate_table(out, matcher, name);
+  else
+    generate_direct(out, matcher, name);
+
+  out << "#endif\n";
+}
+
+void DFA_Codegen::generate_table(ostream& out, const DFA_Matcher& matcher,
+    const string& name)
+{
+  unsigned classes {matcher.get_class_count()};
+  string state_type {index_type(matcher.size())};
+
+  // One representative byte per class gives the class' column
+  vector<unsigned> byte_class(256);
+  vector<unsigned char> representative(classes, 0);
+  for (unsigned c {0}; c < 256; c++)
+  {
+    byte_class[c] = matcher.get_byte_class(c);
+    if (byte_class[c] != 0)
+      representative[byte_class[c]] = c;
+  }
+
+  vector<uint32_t> table;
+  vector<unsigned> accepting;
+  for (uint32_t state {0}; state < matcher.size(); state++)
+  {
+    for (unsigned cls {0}; cls < classes; cls++)
+    {
+      table.push_back(cls == 0 ? DFA_Matcher::DEAD :
+          matcher.delta(state, representative[cls]));
+    }
+
+    accepting.push_back(matcher.is_accepting(state));
+  }
+
+  out << "inline constexpr " << index_type(classes) << " " << name
+    << "_classes[256] ";
+  write_array(out, byte_class);
+
+  out << "inline constexpr " << state_type << " " << name << "_table["
+    << table.size() << "] ";
+  write_array(out, table);
+
+  out << "inline constexpr bool " << name << "_accepting["
+    << accepting.size() << "] ";
+  out << "{";
+  for (size_t i {0}; i < accepting.size(); i++)
+  {
+    out << (i % ENTRIES_PER_LINE == 0 ? "\n  " : " ")
+      << (accepting[i] ? "true" : "false")
+      << (i + 1 < accepting.size() ? "," : "");
+  }
+
+  out << "\n};\n\n";
+
+  out << "inline bool " << name << "_accept(std::string_view input)\n"
+    << "{\n"
+    << "  " << state_type << " state {" << matcher.get_start_state()
+    << "};\n"
+    << "  for (unsigned char c : input)\n"
+    << "  {\n"
+    << "    state = " << name << "_table[state * " << classes << " + "
+    << name << "_classes[c]];\n"
+    << "    if (state == " << DFA_Matcher::DEAD << ")\n"
+    << "      return false;\n"
+    << "  }\n\n"
+    << "  return " << name << "_accepting[state];\n"
+    << "}\n\n";
+}
+
+void DFA_Codegen::generate_direct(ostream& out, const DFA_Matcher& matcher,
+    const string& name)
+{
+  out << "inline bool " << name << "_accept(std::string_view input)\n"
+    << "{\n"
+    << "  auto p {reinterpret_cast<const unsigned char*>(input.data())};\n"
+    << "  auto end {p + input.size()};\n"
+    << "  goto s" << matcher.get_start_state() << ";\n";
+
+  for (uint32_t state {1}; state < matcher.size(); state++)
+  {
+    // Group the characters by destination, the dead state being the default
+    map<uint32_t, vector<char>> cases;
+    for (char c {ALPHABET_START}; c <= ALPHABET_END; c++)
+    {
+      uint32_t dst {matcher.delta(state, c)};
+      if (dst != DFA_Matcher::DEAD)
+        cases[dst].push_back(c);
+    }
+
+    out << "\n"
+      << "s" << state << ":\n"
+      << "  if (p == end)\n"
+      << "    return " << (matcher.is_accepting(state) ? "true" : "false")
+      << ";\n\n";
+
+    if (cases.empty())
+    {
+      out << "  return false;\n";
+      continue;
+    }
+
+    out << "  switch (*p++)\n"
+      << "  {\n";
+
+    for (auto& p : cases)
+    {
+      for (size_t i {0}; i < p.second.size(); i++)
+      {
+        out << (i % 4 == 0 ? "    " : " ") << "case "
+          << char_literal(p.second[i]) << ":"
+          << (i % 4 == 3 || i + 1 == p.second.size() ? "\n" : "");
+      }
+
+      out << "      goto s" << p.first << ";\n";
+    }
+
+    out << "    default:\n"
+      << "      return false;\n"
+      << "  }\n";
+  }
+
+  out << "}\n\n";
+}
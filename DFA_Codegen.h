@@ -0,0 +1,48 @@
+#ifndef DFA_CODEGEN_H
+#define DFA_CODEGEN_H
+
+#include <ostream>
+#include <string>
+
+#include "DFA_Matcher.h"
+
+/*
+ * A class that generates a self-contained C++ header from a compiled
+ * matcher. The header defines
+ *
+ *   inline bool <name>_accept(std::string_view input);
+ *
+ * and needs nothing from this project.
+ */
+class DFA_Codegen
+{
+  private:
+
+    /*
+     * Private constructor
+     */
+    DFA_Codegen() {}
+
+    static void generate_table(std::ostream& out, const DFA_Matcher& matcher,
+        const std::string& name);
+
+    static void generate_direct(std::ostream& out, const DFA_Matcher& matcher,
+        const std::string& name);
+
+  public:
+    enum class Mode
+    {
+      TABLE,    // transition tables and a lookup loop
+      DIRECT    // one label per state, switch and goto
+    };
+
+    /*
+     * Writes a header recognizing the same language as matcher.
+     * name prefixes every generated identifier, and pattern is recorded
+     * in the header as <name>_pattern.
+     */
+    static void generate(std::ostream& out, const DFA_Matcher& matcher,
+        const std::string& name, const std::string& pattern, Mode mode);
+};
+
+#endif
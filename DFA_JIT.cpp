@@ -0,0 +1,225 @@
+/*
+ * DFA_JIT implementation file
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "DFA_JIT.h"
+#include "DFA_Matcher.h"
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#define DFA_JIT_SUPPORTED 1
+#endif
+
+using namespace std;
+
+#ifdef DFA_JIT_SUPPORTED
+
+/*
+ * Assembles x86-64 code with forward and backward rel32 jumps.
+ * The generated function follows the System V calling convention:
+ * rdi is the next byte, rsi the end of the input, and al the result.
+ */
+class Assembler
+{
+  public:
+    vector<uint8_t> code;
+
+    // Offsets of the labels, and of the jumps waiting for them
+    vector<size_t> labels;
+    vector<pair<size_t, size_t>> fixups;
+
+    size_t new_label()
+    {
+      labels.push_back(0);
+      return labels.size() - 1;
+    }
+
+    void bind(size_t label) { labels[label] = code.size(); }
+
+    void emit(initializer_list<uint8_t> bytes)
+    {
+      code.insert(code.end(), bytes);
+    }
+
+    /*
+     * Emits a jump opcode followed by a rel32 to label
+     */
+    void jump(initializer_list<uint8_t> opcode, size_t label)
+    {
+      emit(opcode);
+      fixups.emplace_back(code.size(), label);
+      emit({0, 0, 0, 0});
+    }
+
+    void jmp(size_t label) { jump({0xE9}, label); }
+    void je(size_t label) { jump({0x0F, 0x84}, label); }
+    void jbe(size_t label) { jump({0x0F, 0x86}, label); }
+
+    /*
+     * Resolves the jumps
+     */
+    void link()
+    {
+      for (auto& fixup : fixups)
+      {
+        int32_t rel (labels[fixup.second] - (fixup.first + 4));
+        memcpy(&code[fixup.first], &rel, sizeof(rel));
+      }
+    }
+};
+
+bool DFA_JIT::supported()
+{
+  return true;
+}
+
+DFA_JIT::DFA_JIT(const DFA_Matcher& matcher)
+{
+  Assembler a;
+  size_t accept_label {a.new_label()};
+  size_t reject_label {a.new_label()};
+
+  vector<size_t> state_labels(matcher.size());
+  for (auto& label : state_labels)
+  {
+    label = a.new_label();
+  }
+
+  // Start with the start state so the function's entry is its block
+  vector<uint32_t> order {matcher.get_start_state()};
+  for (uint32_t state {1}; state < matcher.size(); state++)
+  {
+    if (state != matcher.get_start_state())
+      order.push_back(state);
+  }
+
+  for (auto state : order)
+  {
+    a.bind(state_labels[state]);
+
+    // cmp rdi, rsi; je accept or reject
+    a.emit({0x48, 0x39, 0xF7});
+    a.je(matcher.is_accepting(state) ? accept_label : reject_label);
+
+    // movzx eax, byte [rdi]; add rdi, 1
+    a.emit({0x0F, 0xB6, 0x07});
+    a.emit({0x48, 0x83, 0xC7, 0x01});
+
+    // Ranges of bytes with the same successor, self-loops first
+    vector<pair<unsigned, unsigned>> loops, ranges;
+    vector<uint32_t> successors;
+    for (unsigned c {0}; c < 256; c++)
+    {
+      uint32_t dst {matcher.delta(state, c)};
+      if (dst == DFA_Matcher::DEAD)
+        continue;
+
+      auto& list {dst == state ? loops : ranges};
+      bool extend {!list.empty() && list.back().second == c - 1 &&
+        (dst == state || successors.back() == dst)};
+
+      if (extend)
+      {
+        list.back().second = c;
+      }
+      else
+      {
+        list.emplace_back(c, c);
+        if (dst != state)
+          successors.push_back(dst);
+      }
+    }
+
+    auto branch = [&](pair<unsigned, unsigned> range, uint32_t dst)
+    {
+      if (range.first == range.second)
+      {
+        // cmp al, c; je dst
+        a.emit({0x3C, static_cast<uint8_t>(range.first)});
+        a.je(state_labels[dst]);
+      }
+      else
+      {
+        // lea ecx, [rax - first]; cmp ecx, last - first; jbe dst
+        a.emit({0x8D, 0x88});
+        int32_t disp (-static_cast<int32_t>(range.first));
+        a.emit({static_cast<uint8_t>(disp), static_cast<uint8_t>(disp >> 8),
+            static_cast<uint8_t>(disp >> 16), static_cast<uint8_t>(disp >> 24)});
+        a.emit({0x81, 0xF9});
+        uint32_t width {range.second - range.first};
+        a.emit({static_cast<uint8_t>(width), static_cast<uint8_t>(width >> 8),
+            0, 0});
+        a.jbe(state_labels[dst]);
+      }
+    };
+
+    for (auto& range : loops)
+    {
+      branch(range, state);
+    }
+
+    for (size_t i {0}; i < ranges.size(); i++)
+    {
+      branch(ranges[i], successors[i]);
+    }
+
+    a.jmp(reject_label);
+  }
+
+  // mov eax, 1; ret
+  a.bind(accept_label);
+  a.emit({0xB8, 0x01, 0x00, 0x00, 0x00, 0xC3});
+
+  // xor eax, eax; ret
+  a.bind(reject_label);
+  a.emit({0x31, 0xC0, 0xC3});
+
+  a.link();
+
+  // Write the code, then make it executable and read only
+  code_size = a.code.size();
+  code = mmap(nullptr, code_size, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (code == MAP_FAILED)
+  {
+    throw runtime_error("Could not allocate JIT code");
+  }
+
+  memcpy(code, a.code.data(), code_size);
+  if (mprotect(code, code_size, PROT_READ | PROT_EXEC) != 0)
+  {
+    munmap(code, code_size);
+    throw runtime_error("Could not make JIT code executable");
+  }
+
+  function = reinterpret_cast<Function>(code);
+}
+
+DFA_JIT::~DFA_JIT()
+{
+  munmap(code, code_size);
+}
+
+#else
+
+bool DFA_JIT::supported()
+{
+  return false;
+}
+
+DFA_JIT::DFA_JIT(const DFA_Matcher&) :
+  code(nullptr), code_size(0), function(nullptr)
+{
+  throw runtime_error("JIT is not supported on this platform");
+}
+
+DFA_JIT::~DFA_JIT()
+{
+}
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef DFA_JIT_H
+#define DFA_JIT_H
+
+#include <cstddef>
+#include <string_view>
+
+#include "DFA_Matcher.h"
+
+/*
+ * Native code for a matcher's accept function, generated at run time.
+ * Only Linux on x86-64 is supported; elsewhere the constructor throws and
+ * callers keep using the tables.
+ *
+ * Every state is a block that checks for the end of the input, loads the
+ * next byte and compares it against the ranges of bytes leading to each
+ * successor. The ranges looping back to the state are tested first, so a
+ * self-loop runs as a tight loop. The code lives in its own pages, which
+ * are made executable only once written.
+ */
+class DFA_JIT
+{
+  private:
+    typedef bool (*Function)(const unsigned char* begin,
+        const unsigned char* end);
+
+    void* code;
+    size_t code_size;
+    Function function;
+
+  public:
+
+    /*
+     * Returns true iff native code can be generated on this platform
+     */
+    static bool supported();
+
+    /*
+     * Generates native code for matcher.
+     * Throws std::runtime_error if unsupported or out of memory.
+     */
+    DFA_JIT(const DFA_Matcher& matcher);
+    ~DFA_JIT();
+
+    DFA_JIT(const DFA_JIT&) = delete;
+    DFA_JIT& operator=(const DFA_JIT&) = delete;
+
+    /*
+     * Returns true iff the matcher recognizes the whole input
+     */
+    bool accept(std::string_view input) const
+    {
+      auto begin {reinterpret_cast<const unsigned char*>(input.data())};
+      return function(begin, begin + input.size());
+    }
+
+    /*
+     * Returns the number of bytes of generated code
+     */
+    size_t size() const { return code_size; }
+};
+
+#endif
@@ -0,0 +1,644 @@
+/*
+ * DFA_Matcher implementation file
+ */
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "DFA.h"
+#include "DFA_JIT.h"
+#include "DFA_Matcher.h"
+
+using namespace std;
+
+static const char ALPHABET_START {' '};
+static const char ALPHABET_END {'~'};
+
+const uint32_t DFA_Matcher::DEAD {0};
+const size_t DFA_Matcher::MAX_SEARCH_STATES {1 << 14};
+
+DFA_Matcher::DFA_Matcher(const DFA& dfa)
+{
+  // Number the DFA's states, starting at 1 with the start state
+  unordered_map<DFA_State, uint32_t> ids {{DFA::ERROR, DEAD}};
+  vector<const list<DFA_Transition>*> transitions {nullptr};
+
+  ids.emplace(dfa.start_state, 1);
+  transitions.push_back(&dfa.state_map.at(dfa.start_state));
+
+  for (auto& p : dfa.state_map)
+  {
+    if (ids.emplace(p.first, transitions.size()).second)
+    {
+      transitions.push_back(&p.second);
+    }
+  }
+
+  accepting.assign(transitions.size(), 0);
+  for (auto& state : dfa.accepted_set)
+  {
+    accepting[ids.at(state)] = 1;
+  }
+
+  start_state = ids.at(dfa.start_state);
+
+  // Column of destination states for each character
+  vector<vector<uint32_t>> columns(ALPHABET_END + 1,
+      vector<uint32_t>(transitions.size(), DEAD));
+
+  for (uint32_t state {1}; state < transitions.size(); state++)
+  {
+    for (auto& t : *transitions[state])
+    {
+      columns[t.character][state] = ids.at(t.dst_node_id);
+    }
+  }
+
+  /*
+   * Characters with identical columns share a class.
+   * Class 0 holds the characters that always lead to the dead state,
+   * including every byte outside the alphabet.
+   */
+  map<vector<uint32_t>, uint8_t> classes {
+    {vector<uint32_t>(transitions.size(), DEAD), 0}};
+
+  byte_class.fill(0);
+  for (char c {ALPHABET_START}; c <= ALPHABET_END; c++)
+  {
+    auto it {classes.emplace(columns[c], classes.size()).first};
+    byte_class[static_cast<unsigned char>(c)] = it->second;
+  }
+
+  class_count = classes.size();
+
+  // Fill the table one class at a time
+  vector<uint32_t> table(transitions.size() * class_count, DEAD);
+  for (char c {ALPHABET_START}; c <= ALPHABET_END; c++)
+  {
+    unsigned cls {byte_class[static_cast<unsigned char>(c)]};
+    for (uint32_t state {0}; state < transitions.size(); state++)
+    {
+      table[state * class_count + cls] = columns[c][state];
+    }
+  }
+
+  prune(table);
+  set_table(table);
+  layout();
+  build_unanchored();
+}
+
+DFA_Matcher::DFA_Matcher(const DFA_Matcher& anchored,
+    const vector<uint32_t>& table, vector<uint8_t> a) :
+  byte_class(anchored.byte_class), class_count(anchored.class_count),
+  accepting(std::move(a)), start_state(1)
+{
+  auto pruned {table};
+  prune(pruned);
+  set_table(pruned);
+  layout();
+}
+
+void DFA_Matcher::build_unanchored()
+{
+  auto table {get_table()};
+
+  /*
+   * Subset construction over the matcher's states. A match may start at
+   * any byte, so every subset holds the start state; bytes outside the
+   * alphabet, which kill every match, lead back to the start subset.
+   * Subset 0 is the dead state.
+   */
+  vector<vector<uint32_t>> subsets {{}, {start_state}};
+  map<vector<uint32_t>, uint32_t> ids {{subsets[1], 1}};
+  vector<uint8_t> subset_accepting {0, accepting[start_state]};
+  vector<uint32_t> subset_table(2 * class_count, DEAD);
+
+  for (uint32_t s {1}; s < subsets.size(); s++)
+  {
+    auto subset {subsets[s]};
+    for (unsigned cls {0}; cls < class_count; cls++)
+    {
+      vector<uint32_t> dst {start_state};
+      for (auto state : subset)
+      {
+        auto next {table[state * class_count + cls]};
+        if (next != DEAD)
+          dst.push_back(next);
+      }
+
+      std::sort(dst.begin(), dst.end());
+      dst.erase(std::unique(dst.begin(), dst.end()), dst.end());
+
+      auto [it, added] {ids.emplace(dst, subsets.size())};
+      if (added)
+      {
+        // Too large: search() simulates the subsets instead
+        if (subsets.size() == MAX_SEARCH_STATES)
+          return;
+
+        subset_accepting.push_back(std::any_of(dst.begin(), dst.end(),
+              [&](uint32_t state) { return accepting[state] != 0; }));
+        subsets.push_back(std::move(dst));
+        subset_table.resize(subsets.size() * class_count, DEAD);
+      }
+
+      subset_table[s * class_count + cls] = it->second;
+    }
+  }
+
+  unanchored.reset(new DFA_Matcher(*this, subset_table,
+        std::move(subset_accepting)));
+}
+
+/*
+ * Returns true iff the input is made of characters of the alphabet
+ */
+static bool in_alphabet(string_view input)
+{
+  return std::all_of(input.begin(), input.end(), [](char c)
+  {
+    return c >= ALPHABET_START && c <= ALPHABET_END;
+  });
+}
+
+void DFA_Matcher::prune(vector<uint32_t>& table) const
+{
+  // Walk the transitions backwards from the accepting states
+  vector<vector<uint32_t>> predecessors(size());
+  for (uint32_t state {1}; state < size(); state++)
+  {
+    for (unsigned cls {0}; cls < class_count; cls++)
+    {
+      predecessors[table[state * class_count + cls]].push_back(state);
+    }
+  }
+
+  vector<bool> live(size());
+  vector<uint32_t> work_list;
+  for (uint32_t state {1}; state < size(); state++)
+  {
+    if (accepting[state])
+    {
+      live[state] = true;
+      work_list.push_back(state);
+    }
+  }
+
+  while (!work_list.empty())
+  {
+    auto state {work_list.back()};
+    work_list.pop_back();
+
+    for (auto p : predecessors[state])
+    {
+      if (!live[p])
+      {
+        live[p] = true;
+        work_list.push_back(p);
+      }
+    }
+  }
+
+  for (auto& dst : table)
+  {
+    if (!live[dst])
+    {
+      dst = DEAD;
+    }
+  }
+}
+
+vector<bool> DFA_Matcher::find_accept_all(const vector<uint32_t>& table)
+  const
+{
+  // The classes the characters of the alphabet fall in
+  vector<bool> used(class_count);
+  for (char c {ALPHABET_START}; c <= ALPHABET_END; c++)
+  {
+    used[byte_class[static_cast<unsigned char>(c)]] = true;
+  }
+
+  /*
+   * Start from the accepting states, and drop the states with a
+   * character leading out of the set until none is left to drop
+   */
+  vector<bool> accept_all(size());
+  for (uint32_t state {1}; state < size(); state++)
+  {
+    accept_all[state] = accepting[state];
+  }
+
+  for (bool changed {true}; changed;)
+  {
+    changed = false;
+    for (uint32_t state {1}; state < size(); state++)
+    {
+      if (!accept_all[state])
+        continue;
+
+      for (unsigned cls {0}; cls < class_count; cls++)
+      {
+        if (used[cls] && !accept_all[table[state * class_count + cls]])
+        {
+          accept_all[state] = false;
+          changed = true;
+          break;
+        }
+      }
+    }
+  }
+
+  return accept_all;
+}
+
+DFA_Matcher::~DFA_Matcher()
+{
+}
+
+void DFA_Matcher::set_jit_threshold(uint64_t threshold)
+{
+  jit_threshold = DFA_JIT::supported() ? threshold : 0;
+}
+
+vector<uint32_t> DFA_Matcher::get_table() const
+{
+  switch (state_width)
+  {
+    case 1:
+      return vector<uint32_t>(table8.begin(), table8.end());
+    case 2:
+      return vector<uint32_t>(table16.begin(), table16.end());
+    default:
+      return table32;
+  }
+}
+
+void DFA_Matcher::set_table(const vector<uint32_t>& table)
+{
+  table8.clear();
+  table16.clear();
+  table32.clear();
+
+  if (size() <= 1 << 8 && min_state_width <= 1)
+  {
+    state_width = 1;
+    table8.assign(table.begin(), table.end());
+  }
+  else if (size() <= 1 << 16 && min_state_width <= 2)
+  {
+    state_width = 2;
+    table16.assign(table.begin(), table.end());
+  }
+  else
+  {
+    state_width = 4;
+    table32 = table;
+  }
+}
+
+void DFA_Matcher::widen(unsigned width)
+{
+  if (width > state_width)
+  {
+    auto table {get_table()};
+    min_state_width = width;
+    set_table(table);
+  }
+}
+
+void DFA_Matcher::layout(const vector<uint64_t>& visits)
+{
+  auto table {get_table()};
+
+  // Breadth first order from the start state, classes in order
+  vector<uint32_t> order {start_state};
+  vector<bool> seen(size());
+  seen[DEAD] = seen[start_state] = true;
+
+  for (size_t i {0}; i < order.size(); i++)
+  {
+    for (unsigned cls {0}; cls < class_count; cls++)
+    {
+      auto dst {table[order[i] * class_count + cls]};
+      if (!seen[dst])
+      {
+        seen[dst] = true;
+        order.push_back(dst);
+      }
+    }
+  }
+
+  // Hottest first after the start state
+  if (!visits.empty())
+  {
+    std::stable_sort(order.begin() + 1, order.end(),
+        [&](uint32_t a, uint32_t b)
+        {
+          return (a < visits.size() ? visits[a] : 0) >
+            (b < visits.size() ? visits[b] : 0);
+        });
+  }
+
+  /*
+   * The states accepting every continuation go last. If the start state
+   * is one, so are the states it reaches.
+   */
+  auto accept_all {find_accept_all(table)};
+  auto first_accept_all {std::stable_partition(order.begin() + 1,
+      order.end(), [&](uint32_t s) { return !accept_all[s]; })};
+
+  accept_all_begin = accept_all[start_state] ? 1 :
+    first_accept_all - order.begin() + 1;
+
+  vector<uint32_t> ids(size(), DEAD);
+  for (size_t i {0}; i < order.size(); i++)
+  {
+    ids[order[i]] = i + 1;
+  }
+
+  // Unreachable states are dropped
+  vector<uint32_t> new_table((order.size() + 1) * class_count, DEAD);
+  vector<uint8_t> new_accepting(order.size() + 1, 0);
+  for (size_t i {0}; i < order.size(); i++)
+  {
+    for (unsigned cls {0}; cls < class_count; cls++)
+    {
+      new_table[(i + 1) * class_count + cls] =
+        ids[table[order[i] * class_count + cls]];
+    }
+
+    new_accepting[i + 1] = accepting[order[i]];
+  }
+
+  accepting = std::move(new_accepting);
+  start_state = 1;
+  set_table(new_table);
+}
+
+void DFA_Matcher::count_visits(string_view input,
+    vector<uint64_t>& visits) const
+{
+  if (visits.size() < size())
+  {
+    visits.resize(size());
+  }
+
+  with_rows([&](auto rows)
+  {
+    uint32_t state {start_state};
+    visits[state]++;
+
+    for (unsigned char c : input)
+    {
+      state = rows.delta(state, c);
+      visits[state]++;
+      if (state == DEAD)
+        break;
+    }
+  });
+}
+
+void DFA_Matcher::count_use() const
+{
+  // Stop counting once past the threshold, so hot matchers shared by
+  // several threads don't contend on the counter
+  if (uses.load(memory_order_relaxed) >= jit_threshold ||
+      uses.fetch_add(1, memory_order_relaxed) + 1 != jit_threshold)
+  {
+    return;
+  }
+
+  try
+  {
+    jit_code = std::make_unique<DFA_JIT>(*this);
+    jit.store(jit_code.get(), memory_order_release);
+  }
+  catch (std::runtime_error&)
+  {
+    // Keep using the tables
+  }
+}
+
+template <typename State_T>
+bool DFA_Matcher::accept(const vector<State_T>& table, string_view input)
+  const
+{
+  const State_T* rows {table.data()};
+  uint32_t state {start_state};
+  size_t i {0};
+
+  for (; i < input.size() && !is_final(state); i++)
+  {
+    state = rows[state * class_count +
+      byte_class[static_cast<unsigned char>(input[i])]];
+  }
+
+  // The rest of the input only has to stay in the alphabet
+  if (accepts_all(state))
+  {
+    return in_alphabet(input.substr(i));
+  }
+
+  return accepting[state];
+}
+
+template <typename State_T>
+size_t DFA_Matcher::first_accept(const vector<State_T>& table,
+    string_view input) const
+{
+  const State_T* rows {table.data()};
+  uint32_t state {start_state};
+  if (accepting[state])
+  {
+    return 0;
+  }
+
+  for (size_t i {0}; i < input.size(); i++)
+  {
+    state = rows[state * class_count +
+      byte_class[static_cast<unsigned char>(input[i])]];
+    if (accepting[state])
+      return i + 1;
+
+    if (state == DEAD)
+      break;
+  }
+
+  return string_view::npos;
+}
+
+template <typename State_T>
+size_t DFA_Matcher::simulate_search(const vector<State_T>& table,
+    string_view input) const
+{
+  const State_T* rows {table.data()};
+  if (accepting[start_state])
+  {
+    return 0;
+  }
+
+  // The states of the matches started so far, each once. A state is in
+  // next iff its mark is the offset after the byte.
+  vector<uint32_t> current {start_state};
+  vector<uint32_t> next;
+  vector<size_t> mark(size(), 0);
+
+  for (size_t i {0}; i < input.size(); i++)
+  {
+    unsigned cls {byte_class[static_cast<unsigned char>(input[i])]};
+    next.assign({start_state});
+    mark[start_state] = i + 1;
+
+    for (auto state : current)
+    {
+      uint32_t dst {rows[state * class_count + cls]};
+      if (accepting[dst])
+        return i + 1;
+
+      if (dst != DEAD && mark[dst] != i + 1)
+      {
+        mark[dst] = i + 1;
+        next.push_back(dst);
+      }
+    }
+
+    current.swap(next);
+  }
+
+  return string_view::npos;
+}
+
+template <typename State_T>
+bool DFA_Matcher::search(const vector<State_T>& table, string_view input,
+    size_t last_begin, size_t& match_begin, size_t& match_end) const
+{
+  const State_T* rows {table.data()};
+
+  for (size_t begin {0}; begin <= last_begin; begin++)
+  {
+    // Run until the dead state, remembering the last accepting position
+    uint32_t state {start_state};
+    bool matched {accepting[state] != 0};
+    size_t end {begin};
+
+    for (size_t i {begin}; i < input.size(); i++)
+    {
+      state = rows[state * class_count +
+        byte_class[static_cast<unsigned char>(input[i])]];
+      if (state == DEAD)
+        break;
+
+      if (accepting[state])
+      {
+        matched = true;
+        end = i + 1;
+      }
+
+      // The match extends to the end of the alphabet characters
+      if (accepts_all(state))
+      {
+        end = std::find_if(input.begin() + end, input.end(), [](char c)
+        {
+          return c < ALPHABET_START || c > ALPHABET_END;
+        }) - input.begin();
+        break;
+      }
+    }
+
+    if (matched)
+    {
+      match_begin = begin;
+      match_end = end;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool DFA_Matcher::accept(string_view input) const
+{
+  if (jit_threshold != 0)
+  {
+    auto native {jit.load(memory_order_acquire)};
+    if (native != nullptr)
+    {
+      return native->accept(input);
+    }
+
+    count_use();
+  }
+
+  switch (state_width)
+  {
+    case 1:
+      return accept(table8, input);
+    case 2:
+      return accept(table16, input);
+    default:
+      return accept(table32, input);
+  }
+}
+
+size_t DFA_Matcher::first_match_end(string_view input) const
+{
+  if (unanchored == nullptr)
+  {
+    switch (state_width)
+    {
+      case 1:
+        return simulate_search(table8, input);
+      case 2:
+        return simulate_search(table16, input);
+      default:
+        return simulate_search(table32, input);
+    }
+  }
+
+  switch (unanchored->state_width)
+  {
+    case 1:
+      return unanchored->first_accept(unanchored->table8, input);
+    case 2:
+      return unanchored->first_accept(unanchored->table16, input);
+    default:
+      return unanchored->first_accept(unanchored->table32, input);
+  }
+}
+
+bool DFA_Matcher::search(string_view input) const
+{
+  return first_match_end(input) != string_view::npos;
+}
+
+bool DFA_Matcher::search(string_view input, size_t& match_begin,
+    size_t& match_end) const
+{
+  auto first_end {first_match_end(input)};
+  if (first_end == string_view::npos)
+  {
+    return false;
+  }
+
+  switch (state_width)
+  {
+    case 1:
+      return search(table8, input, first_end, match_begin, match_end);
+    case 2:
+      return search(table16, input, first_end, match_begin, match_end);
+    default:
+      return search(table32, input, first_end, match_begin, match_end);
+  }
+}
+
+size_t DFA_Matcher::memory_usage() const
+{
+  return sizeof(byte_class) + size() * class_count * state_width +
+    accepting.size() * sizeof(accepting[0]) +
+    (unanchored != nullptr ? unanchored->memory_usage() : 0);
+}
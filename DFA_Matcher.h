@@ -0,0 +1,347 @@
+#ifndef DFA_MATCHER_H
+#define DFA_MATCHER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "DFA.h"
+
+class DFA_JIT;
+
+/*
+ * An immutable, table driven matcher compiled from a DFA.
+ * All member functions are const and, except as noted below, never
+ * allocate, so a single matcher can be shared by any number of threads.
+ *
+ * Bytes are mapped to equivalence classes (bytes with identical columns
+ * in the transition table), and the table holds one row of class
+ * entries per state, each entry as narrow as the state count allows.
+ * State 0 is a dead state that loops on every class.
+ * The other states are numbered in breadth first order from the start
+ * state, so the rows reached early in the input sit together; layout()
+ * can renumber them by a profile of sample inputs instead.
+ *
+ * States from which no accepting state can be reached are merged into the
+ * dead state, and states that accept every continuation over the alphabet
+ * are numbered last, so the matching loops stop as soon as the result is
+ * known with a single comparison per byte.
+ *
+ * search() runs a single pass over an unanchored matcher, the DFA of the
+ * strings with a suffix the matcher recognizes, built with the tables by
+ * subset construction over the matcher's states. If that DFA would have
+ * more than MAX_SEARCH_STATES states, search() instead tracks the set of
+ * states of the matches started so far, which allocates.
+ *
+ * A matcher with a JIT threshold counts its accept() calls, and the call
+ * reaching the threshold compiles it to native code (see DFA_JIT) that
+ * later calls use. Only that call allocates.
+ */
+class DFA_Matcher
+{
+  private:
+
+    // The equivalence class of each byte
+    std::array<uint8_t, 256> byte_class;
+
+    // Number of byte equivalence classes
+    unsigned class_count;
+
+    /*
+     * Transition table, indexed by state * class_count + class, in the
+     * narrowest of the three that fits the state numbers. The others are
+     * empty.
+     */
+    std::vector<uint8_t> table8;
+    std::vector<uint16_t> table16;
+    std::vector<uint32_t> table32;
+
+    // Size in bytes of the table's entries
+    unsigned state_width;
+
+    // Narrowest entries set_table() may pick, see widen()
+    unsigned min_state_width {1};
+
+    // accepting[s] != 0 iff s is an accepting state
+    std::vector<uint8_t> accepting;
+
+    // The start state
+    uint32_t start_state;
+
+    // The states that accept every continuation are the ones from here on
+    uint32_t accept_all_begin;
+
+    // accept() calls before compiling to native code, 0 for never
+    uint64_t jit_threshold {0};
+
+    mutable std::atomic<uint64_t> uses {0};
+
+    // The native code, published through jit once generated
+    mutable std::unique_ptr<DFA_JIT> jit_code;
+    mutable std::atomic<const DFA_JIT*> jit {nullptr};
+
+    // The unanchored matcher, null if it is too large
+    std::unique_ptr<const DFA_Matcher> unanchored;
+
+    /*
+     * Constructs the unanchored matcher of anchored from its table
+     */
+    DFA_Matcher(const DFA_Matcher& anchored,
+        const std::vector<uint32_t>& table, std::vector<uint8_t> accepting);
+
+    /*
+     * Builds the unanchored matcher, unless it has too many states
+     */
+    void build_unanchored();
+
+    /*
+     * Returns the table with 32 bit entries
+     */
+    std::vector<uint32_t> get_table() const;
+
+    /*
+     * Stores the table in the narrowest entries that fit
+     */
+    void set_table(const std::vector<uint32_t>& table);
+
+    /*
+     * Redirects the transitions into states that can't reach an accepting
+     * state to the dead state
+     */
+    void prune(std::vector<uint32_t>& table) const;
+
+    /*
+     * Returns, for each state, whether it accepts every continuation
+     */
+    std::vector<bool> find_accept_all(
+        const std::vector<uint32_t>& table) const;
+
+    /*
+     * The matching loops over a table of each width. The public
+     * functions pick one per call, not per byte.
+     */
+    template <typename State_T>
+    bool accept(const std::vector<State_T>& table,
+        std::string_view input) const;
+
+    template <typename State_T>
+    size_t first_accept(const std::vector<State_T>& table,
+        std::string_view input) const;
+
+    template <typename State_T>
+    size_t simulate_search(const std::vector<State_T>& table,
+        std::string_view input) const;
+
+    template <typename State_T>
+    bool search(const std::vector<State_T>& table, std::string_view input,
+        size_t last_begin, size_t& match_begin, size_t& match_end) const;
+
+    /*
+     * Returns the end of the earliest ending match in the input, or
+     * std::string_view::npos if there is none
+     */
+    size_t first_match_end(std::string_view input) const;
+
+    /*
+     * Returns true iff the matching loops can stop in the state
+     */
+    bool is_final(uint32_t state) const
+    {
+      // Wraps around for the dead state
+      return state - 1 >= accept_all_begin - 1;
+    }
+
+    /*
+     * Counts a use, generating native code at the threshold
+     */
+    void count_use() const;
+
+  public:
+
+    /*
+     * The dead state. Once entered, the input cannot be accepted.
+     */
+    static const uint32_t DEAD;
+
+    /*
+     * Largest unanchored matcher built for search()
+     */
+    static const size_t MAX_SEARCH_STATES;
+
+    /*
+     * Compiles a DFA into transition tables
+     */
+    DFA_Matcher(const DFA& dfa);
+    ~DFA_Matcher();
+
+    /*
+     * Compiles the matcher to native code after uses accept() calls.
+     * 0, the default, never does. Has no effect where DFA_JIT is not
+     * supported.
+     */
+    void set_jit_threshold(uint64_t uses);
+
+    /*
+     * Renumbers the states so that the most visited rows of the table are
+     * adjacent, keeping the dead state at 0, the start state at 1 and the
+     * states that accept every continuation last.
+     * visits holds a count per state, as from count_visits(); states with
+     * equal counts, or all states if visits is empty, are in breadth first
+     * order from the start state. Invalidates the matcher's state numbers,
+     * so it must be called before the matcher is shared or compiled.
+     */
+    void layout(const std::vector<uint64_t>& visits = {});
+
+    /*
+     * Stores the table in entries of at least width bytes (1, 2 or 4), so
+     * that matchers stepped together can share a width. Must be called
+     * before the matcher is shared or compiled.
+     */
+    void widen(unsigned width);
+
+    /*
+     * Adds the states visited by accept(input) to visits, which is
+     * resized to size() if needed
+     */
+    void count_visits(std::string_view input,
+        std::vector<uint64_t>& visits) const;
+
+    /*
+     * A view of the transition table with entries of type State_T
+     */
+    template <typename State_T>
+    class Rows
+    {
+      private:
+        const State_T* table;
+        const uint8_t* byte_class;
+        unsigned class_count;
+
+      public:
+        Rows(const std::vector<State_T>& t, const DFA_Matcher& matcher) :
+          table(t.data()), byte_class(matcher.byte_class.data()),
+          class_count(matcher.class_count) {}
+
+        uint32_t delta(uint32_t state, unsigned char c) const
+        {
+          return table[state * class_count + byte_class[c]];
+        }
+    };
+
+    /*
+     * Returns the Rows of the table, whose entries must be State_T
+     */
+    template <typename State_T>
+    Rows<State_T> get_rows() const
+    {
+      if constexpr (sizeof(State_T) == 1)
+        return {table8, *this};
+      else if constexpr (sizeof(State_T) == 2)
+        return {table16, *this};
+      else
+        return {table32, *this};
+    }
+
+    /*
+     * Calls f with the Rows of the table and returns its result. Loops
+     * stepping the matcher byte by byte go in f, so the table width is
+     * picked once per call rather than once per byte. f must return the
+     * same type for every width.
+     */
+    template <typename F>
+    decltype(auto) with_rows(F&& f) const
+    {
+      switch (state_width)
+      {
+        case 1:
+          return f(get_rows<uint8_t>());
+        case 2:
+          return f(get_rows<uint16_t>());
+        default:
+          return f(get_rows<uint32_t>());
+      }
+    }
+
+    /*
+     * The matcher's transition function. It picks the table width on
+     * every call: loops should step through with_rows() instead.
+     */
+    uint32_t delta(uint32_t state, unsigned char c) const
+    {
+      size_t i {state * class_count + byte_class[c]};
+      switch (state_width)
+      {
+        case 1:
+          return table8[i];
+        case 2:
+          return table16[i];
+        default:
+          return table32[i];
+      }
+    }
+
+    /*
+     * Returns true iff the matcher recognizes the whole input
+     */
+    bool accept(std::string_view input) const;
+
+    /*
+     * Returns true iff the matcher recognizes some substring of the input
+     */
+    bool search(std::string_view input) const;
+
+    /*
+     * Finds the leftmost-longest substring of the input recognized by the
+     * matcher. Returns false if there is none, otherwise the match is
+     * [match_begin, match_end). The leftmost match starts no later than
+     * the earliest match ends, so only the starts up to there are tried.
+     */
+    bool search(std::string_view input, size_t& match_begin,
+        size_t& match_end) const;
+
+    uint8_t get_byte_class(unsigned char c) const { return byte_class[c]; }
+    uint32_t get_start_state() const { return start_state; }
+    bool is_accepting(uint32_t state) const { return accepting[state]; }
+
+    /*
+     * Returns true iff the state accepts every continuation made of
+     * characters of the alphabet
+     */
+    bool accepts_all(uint32_t state) const
+    {
+      return state >= accept_all_begin;
+    }
+
+    /*
+     * Returns the number of states, including the dead state
+     */
+    size_t size() const { return accepting.size(); }
+
+    /*
+     * Returns the number of byte equivalence classes
+     */
+    unsigned get_class_count() const { return class_count; }
+
+    /*
+     * Returns the size in bytes of the transition table's entries: 1 for
+     * up to 256 states, 2 for up to 65536, otherwise 4
+     */
+    unsigned get_state_width() const { return state_width; }
+
+    /*
+     * Returns the unanchored matcher search() runs, or null if search()
+     * simulates it
+     */
+    const DFA_Matcher* get_unanchored() const { return unanchored.get(); }
+
+    /*
+     * Returns the number of bytes used by the matcher's tables, including
+     * the unanchored matcher's
+     */
+    size_t memory_usage() const;
+};
+
+#endif
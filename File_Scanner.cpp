@@ -0,0 +1,323 @@
+/*
+ * File_Scanner implementation file
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "DFA_Matcher.h"
+#include "File_Scanner.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+const size_t File_Scanner::DEFAULT_CHUNK_SIZE {4 << 20};
+
+// Chunks each thread may search ahead of the printed output
+static const size_t CHUNKS_AHEAD {4};
+
+File_Scanner::File_Scanner(const DFA_Matcher& m, unsigned thread_count,
+    size_t size) :
+  matcher(m), threads(thread_count), chunk_size(max<size_t>(size, 1))
+{
+  if (threads == 0)
+  {
+    threads = max(1u, thread::hardware_concurrency());
+  }
+}
+
+/*
+ * Steps the unanchored matcher over the lines of data starting in
+ * [position, end), each up to the first accepting state or its end, and
+ * calls found(line number, line) for the lines with a match. Returns the
+ * number of lines.
+ */
+template <typename Rows, typename F>
+static size_t search_lines(const DFA_Matcher& unanchored, Rows rows,
+    const char* data, size_t size, size_t position, size_t end, F found)
+{
+  uint32_t start {unanchored.get_start_state()};
+  size_t lines {0};
+
+  while (position < end)
+  {
+    size_t line_begin {position};
+    uint32_t state {start};
+    while (position < size && data[position] != '\n' &&
+        !unanchored.is_accepting(state))
+    {
+      state = rows.delta(state, data[position++]);
+    }
+
+    if (unanchored.is_accepting(state))
+    {
+      // Past the match, only the end of the line is left to find
+      auto newline {static_cast<const char*>(
+          memchr(data + position, '\n', size - position))};
+
+      position = newline != nullptr ? newline - data : size;
+      found(lines, string_view(data + line_begin, position - line_begin));
+    }
+
+    lines++;
+    position++;
+  }
+
+  return lines;
+}
+
+void File_Scanner::add_files(const string& path)
+{
+  error_code error;
+  if (!fs::is_directory(path, error))
+  {
+    files.emplace_back();
+    files.back().path = path;
+    return;
+  }
+
+  // Walk the directory, in sorted order so the output is repeatable
+  vector<string> found;
+  fs::recursive_directory_iterator it(path,
+      fs::directory_options::skip_permission_denied, error);
+
+  for (; !error && it != fs::recursive_directory_iterator();
+      it.increment(error))
+  {
+    if (it->is_regular_file(error))
+      found.push_back(it->path().string());
+  }
+
+  if (error)
+  {
+    cerr << path << ": " << error.message() << endl;
+    errors++;
+  }
+
+  sort(found.begin(), found.end());
+  for (auto& file : found)
+  {
+    files.emplace_back();
+    files.back().path = file;
+  }
+}
+
+void File_Scanner::map(File& file)
+{
+  call_once(file.map_once, [&file]()
+  {
+    int fd {open(file.path.c_str(), O_RDONLY)};
+    if (fd < 0)
+    {
+      file.error = errno;
+      return;
+    }
+
+    // Empty files have nothing to map
+    if (file.size == 0)
+    {
+      file.mapped = true;
+      close(fd);
+      return;
+    }
+
+    void* data {mmap(nullptr, file.size, PROT_READ, MAP_PRIVATE, fd, 0)};
+    file.error = errno;
+    close(fd);
+    if (data == MAP_FAILED)
+      return;
+
+    madvise(data, file.size, MADV_SEQUENTIAL);
+    file.data = static_cast<const char*>(data);
+    file.mapped = true;
+  });
+}
+
+void File_Scanner::search(Chunk& chunk)
+{
+  File& file {files[chunk.file]};
+  map(file);
+  if (file.data == nullptr)
+  {
+    return;
+  }
+
+  const char* data {file.data};
+  size_t position {chunk.begin};
+
+  // The line running into the chunk belongs to the previous chunk
+  if (position > 0 && data[position - 1] != '\n')
+  {
+    auto newline {static_cast<const char*>(
+        memchr(data + position, '\n', chunk.end - position))};
+
+    position = newline != nullptr ? newline - data + 1 : chunk.end;
+  }
+
+  auto record = [&chunk](size_t line, string_view text)
+  {
+    chunk.matches.emplace_back(line, text);
+  };
+
+  // One pass over the lines starting in the chunk, to their ends
+  if (auto unanchored {matcher.get_unanchored()}; unanchored != nullptr)
+  {
+    chunk.lines = unanchored->with_rows([&](auto rows)
+    {
+      return search_lines(*unanchored, rows, data, file.size, position,
+          chunk.end, record);
+    });
+
+    return;
+  }
+
+  // Without an unanchored matcher, search each line on its own
+  while (position < chunk.end)
+  {
+    auto newline {static_cast<const char*>(
+        memchr(data + position, '\n', file.size - position))};
+
+    size_t line_end {newline != nullptr ?
+      static_cast<size_t>(newline - data) : file.size};
+
+    string_view line(data + position, line_end - position);
+    if (matcher.search(line))
+    {
+      record(chunk.lines, line);
+    }
+
+    chunk.lines++;
+    position = line_end + 1;
+  }
+}
+
+void File_Scanner::work()
+{
+  size_t window {static_cast<size_t>(threads) * CHUNKS_AHEAD};
+  while (true)
+  {
+    unique_lock<std::mutex> lock(mutex);
+    chunk_printed.wait(lock, [&]()
+    {
+      return next_chunk == chunks.size() || next_chunk < printed + window;
+    });
+
+    if (next_chunk == chunks.size())
+    {
+      return;
+    }
+
+    Chunk& chunk {chunks[next_chunk++]};
+    lock.unlock();
+
+    search(chunk);
+
+    lock.lock();
+    chunk.done = true;
+    chunk_done.notify_all();
+  }
+}
+
+size_t File_Scanner::scan(const vector<string>& paths, ostream& out)
+{
+  files.clear();
+  chunks.clear();
+  next_chunk = 0;
+  printed = 0;
+  errors = 0;
+
+  for (auto& path : paths)
+  {
+    add_files(path);
+  }
+
+  // Cut the files into chunks
+  for (size_t f {0}; f < files.size(); f++)
+  {
+    error_code error;
+    files[f].size = fs::file_size(files[f].path, error);
+    if (error)
+    {
+      cerr << files[f].path << ": " << error.message() << endl;
+      errors++;
+      continue;
+    }
+
+    size_t begin {0};
+    do
+    {
+      size_t end {min(files[f].size, begin + chunk_size)};
+      chunks.push_back({f, begin, end, end == files[f].size, 0, {}, false});
+      begin = end;
+    }
+    while (begin < files[f].size);
+  }
+
+  vector<thread> workers;
+  for (unsigned t {0}; t < min<size_t>(threads, chunks.size()); t++)
+  {
+    workers.emplace_back(&File_Scanner::work, this);
+  }
+
+  // Print the chunks in order as they complete
+  size_t matched {0};
+  size_t line_base {0};
+  for (auto& chunk : chunks)
+  {
+    {
+      unique_lock<std::mutex> lock(mutex);
+      chunk_done.wait(lock, [&chunk]() { return chunk.done; });
+    }
+
+    File& file {files[chunk.file]};
+    if (chunk.begin == 0)
+    {
+      line_base = 0;
+      if (!file.mapped)
+      {
+        cerr << file.path << ": " << strerror(file.error) << endl;
+        errors++;
+      }
+    }
+
+    for (auto& match : chunk.matches)
+    {
+      out << file.path << ':' << line_base + match.first + 1 << ':';
+      out.write(match.second.data(), match.second.size());
+      out << '\n';
+    }
+
+    matched += chunk.matches.size();
+    line_base += chunk.lines;
+    chunk.matches = {};
+
+    if (chunk.last && file.data != nullptr)
+    {
+      munmap(const_cast<char*>(file.data), file.size);
+      file.data = nullptr;
+    }
+
+    lock_guard<std::mutex> lock(mutex);
+    printed++;
+    chunk_printed.notify_all();
+  }
+
+  for (auto& worker : workers)
+  {
+    worker.join();
+  }
+
+  out.flush();
+  return matched;
+}
@@ -0,0 +1,130 @@
+#ifndef FILE_SCANNER_H
+#define FILE_SCANNER_H
+
+#include <condition_variable>
+#include <deque>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "DFA_Matcher.h"
+
+/*
+ * Prints the lines of files that contain a match, like grep.
+ *
+ * Directories are walked recursively. Every file is mmap'd and cut into
+ * chunks that a pool of threads searches with one shared matcher. A
+ * chunk is searched in a single pass over the matcher's unanchored DFA,
+ * which starts over at each newline and skips to the next one from the
+ * first accepting state. Each chunk records its matching lines as views
+ * into the mapping, and the calling thread prints the chunks in order,
+ * so the output is the same as a sequential scan.
+ */
+class File_Scanner
+{
+  private:
+
+    // A file being scanned
+    class File
+    {
+      public:
+        std::string path;
+        size_t size {0};
+
+        // The mapped contents, null until mapped or if mapping failed
+        const char* data {nullptr};
+        bool mapped {false};
+
+        // errno of a failed mapping
+        int error {0};
+        std::once_flag map_once;
+    };
+
+    // A range of a file searched by one thread
+    class Chunk
+    {
+      public:
+        size_t file;
+        size_t begin;
+        size_t end;
+        bool last;
+
+        // Lines starting in the chunk, and the matching ones with their
+        // line number relative to the chunk
+        size_t lines {0};
+        std::vector<std::pair<size_t, std::string_view>> matches;
+
+        bool done {false};
+    };
+
+    const DFA_Matcher& matcher;
+    unsigned threads;
+    size_t chunk_size;
+
+    std::deque<File> files;
+    std::vector<Chunk> chunks;
+
+    std::mutex mutex;
+    std::condition_variable chunk_done;
+    std::condition_variable chunk_printed;
+
+    // Chunks handed out to threads, and printed
+    size_t next_chunk {0};
+    size_t printed {0};
+
+    // Paths the last scan could not read
+    size_t errors {0};
+
+    /*
+     * Adds the regular files under path
+     */
+    void add_files(const std::string& path);
+
+    /*
+     * Maps a file on its first use
+     */
+    void map(File& file);
+
+    /*
+     * Searches the lines starting in a chunk
+     */
+    void search(Chunk& chunk);
+
+    /*
+     * Thread body: searches chunks until none is left
+     */
+    void work();
+
+  public:
+
+    /*
+     * Default size of the chunks files are cut into
+     */
+    static const size_t DEFAULT_CHUNK_SIZE;
+
+    /*
+     * Constructs a scanner using threads threads, 0 for one per hardware
+     * thread
+     */
+    File_Scanner(const DFA_Matcher& matcher, unsigned threads = 0,
+        size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+    /*
+     * Writes "path:line:text" for every line containing a match, in the
+     * order of paths. Returns the number of matching lines. Paths that
+     * can't be read are reported on std::cerr and counted in
+     * error_count().
+     */
+    size_t scan(const std::vector<std::string>& paths, std::ostream& out);
+
+    /*
+     * Returns the number of paths the last scan() could not read
+     */
+    size_t error_count() const { return errors; }
+};
+
+#endif
@@ -0,0 +1,291 @@
+/*
+ * Grouped_Matcher implementation file
+ */
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "DFA.h"
+#include "DFA_Matcher.h"
+#include "Grouped_Matcher.h"
+#include "Position_Automaton.h"
+#include "Regex_AST.h"
+#include "Regex_Compiler.h"
+#include "Regex_Optimizer.h"
+#include "Regex_Parser.h"
+
+using namespace std;
+
+typedef Regex_Node::Type Type;
+
+static const char ALPHABET_START {' '};
+static const char ALPHABET_END {'~'};
+
+/*
+ * Sets next to the positions of the automaton after reading c from the
+ * positions in current
+ */
+static void step(const Position_Automaton& automaton,
+    const Position_Set& current, unsigned char c, Position_Set& next)
+{
+  next.clear();
+  current.for_each([&](size_t p)
+  {
+    const auto& chars {automaton.get_chars(p)};
+    if (c < chars.size() && chars.test(c))
+    {
+      next |= automaton.get_follow(p);
+    }
+  });
+}
+
+Grouped_Matcher::Grouped_Matcher(const vector<string>& patterns, Mode m,
+    size_t max_group_states, const Compile_Limits& limits) : mode(m)
+{
+  Compile_Limits group_limits {limits};
+  group_limits.max_states = min(limits.max_states, max_group_states);
+
+  // The patterns' top level alternatives, which can go to different groups
+  vector<unique_ptr<Regex_Node>> alternatives;
+  for (auto& pattern : patterns)
+  {
+    auto tree {Regex_Optimizer::optimize(Regex_Parser::regex_to_ast(pattern))};
+    if (tree->type != Type::ALTERNATION)
+    {
+      alternatives.push_back(std::move(tree));
+      continue;
+    }
+
+    for (auto& child : tree->children)
+    {
+      alternatives.push_back(std::move(child));
+    }
+  }
+
+  // A search match may start anywhere, after any string of the alphabet
+  if (mode == Mode::SEARCH)
+  {
+    Char_Set any;
+    for (char c {ALPHABET_START}; c <= ALPHABET_END; c++)
+    {
+      any.set(c);
+    }
+
+    for (auto& alternative : alternatives)
+    {
+      alternative = std::make_unique<Regex_Node>(Type::CONCATENATION,
+          std::make_unique<Regex_Node>(Type::CLOSURE,
+            std::make_unique<Regex_Node>(any)), std::move(alternative));
+    }
+  }
+
+  /*
+   * Grow the current group's union until adding an alternative passes
+   * the budget. The union's construction counts its states as it goes,
+   * so a blow up stops at the budget rather than running its course.
+   */
+  unique_ptr<DFA> group;
+  for (auto& alternative : alternatives)
+  {
+    unique_ptr<DFA> dfa;
+    try
+    {
+      dfa = Regex_Compiler::compile_dfa(*alternative, group_limits);
+    }
+    catch (Compile_Limit_Error& e)
+    {
+      if (e.reason() != Compile_Limit_Error::Reason::STATES &&
+          e.reason() != Compile_Limit_Error::Reason::TABLE_BYTES)
+      {
+        throw;
+      }
+
+      // Too large for any group: simulate it
+      simulated.emplace_back(*alternative);
+      continue;
+    }
+
+    if (group != nullptr)
+    {
+      try
+      {
+        Compile_Budget budget {group_limits};
+        *group = DFA::product(*group, *dfa, DFA::Operation::UNION, &budget);
+        continue;
+      }
+      catch (Compile_Limit_Error& e)
+      {
+        // Out of time or cancelled is not a reason for a new group
+        if (e.reason() != Compile_Limit_Error::Reason::STATES &&
+            e.reason() != Compile_Limit_Error::Reason::TABLE_BYTES)
+        {
+          throw;
+        }
+      }
+
+      groups.push_back(std::make_unique<DFA_Matcher>(*group));
+    }
+
+    group = std::move(dfa);
+  }
+
+  if (group != nullptr)
+  {
+    groups.push_back(std::make_unique<DFA_Matcher>(*group));
+  }
+
+  // One table width for all groups, so match() picks it once
+  unsigned width {1};
+  for (auto& g : groups)
+  {
+    width = max(width, g->get_state_width());
+  }
+
+  for (auto& g : groups)
+  {
+    g->widen(width);
+  }
+}
+
+template <typename State_T>
+bool Grouped_Matcher::match(string_view input) const
+{
+  // The groups still running, their tables and states
+  struct Running
+  {
+    const DFA_Matcher* matcher;
+    DFA_Matcher::Rows<State_T> rows;
+    uint32_t state;
+  };
+
+  vector<Running> running;
+
+  // The positions of each simulated automaton, and the next ones
+  vector<Position_Set> positions;
+  vector<Position_Set> next;
+  for (auto& automaton : simulated)
+  {
+    if (automaton.get_first().test(automaton.get_end_marker()))
+    {
+      if (mode == Mode::SEARCH || input.empty())
+        return true;
+    }
+
+    positions.push_back(automaton.get_first());
+    next.emplace_back(automaton.size());
+  }
+
+  for (auto& group : groups)
+  {
+    if (group->is_accepting(group->get_start_state()))
+    {
+      // An empty match, or an empty input accepted
+      if (mode == Mode::SEARCH || input.empty())
+        return true;
+    }
+
+    running.push_back({group.get(), group->get_rows<State_T>(),
+        group->get_start_state()});
+  }
+
+  for (auto c : input)
+  {
+    for (size_t i {0}; i < running.size();)
+    {
+      auto& [matcher, rows, state] {running[i]};
+      state = rows.delta(state, c);
+
+      if (mode == Mode::SEARCH)
+      {
+        // Only a byte outside the alphabet kills a search, and no match
+        // spans it: start over after it
+        if (state == DFA_Matcher::DEAD)
+        {
+          state = matcher->get_start_state();
+        }
+
+        if (matcher->is_accepting(state))
+          return true;
+
+        i++;
+      }
+      else if (state == DFA_Matcher::DEAD)
+      {
+        running[i] = running.back();
+        running.pop_back();
+      }
+      else
+      {
+        i++;
+      }
+    }
+
+    bool live {false};
+    for (size_t i {0}; i < simulated.size(); i++)
+    {
+      auto& automaton {simulated[i]};
+      step(automaton, positions[i], c, next[i]);
+
+      // A match may also start after c
+      if (mode == Mode::SEARCH)
+      {
+        next[i] |= automaton.get_first();
+      }
+
+      std::swap(positions[i], next[i]);
+      if (mode == Mode::SEARCH &&
+          positions[i].test(automaton.get_end_marker()))
+        return true;
+
+      live = live || !positions[i].empty();
+    }
+
+    if (running.empty() && !live)
+      return false;
+  }
+
+  for (size_t i {0}; i < simulated.size(); i++)
+  {
+    if (positions[i].test(simulated[i].get_end_marker()))
+      return true;
+  }
+
+  return any_of(running.begin(), running.end(), [](auto& r)
+  {
+    return r.matcher->is_accepting(r.state);
+  });
+}
+
+bool Grouped_Matcher::match(string_view input) const
+{
+  switch (groups.empty() ? 1 : groups.front()->get_state_width())
+  {
+    case 1:
+      return match<uint8_t>(input);
+    case 2:
+      return match<uint16_t>(input);
+    default:
+      return match<uint32_t>(input);
+  }
+}
+
+size_t Grouped_Matcher::memory_usage() const
+{
+  size_t ret {0};
+  for (auto& group : groups)
+  {
+    ret += group->memory_usage();
+  }
+
+  for (auto& automaton : simulated)
+  {
+    ret += automaton.size() *
+      (sizeof(Char_Set) + (automaton.size() + 63) / 64 * sizeof(uint64_t));
+  }
+
+  return ret;
+}
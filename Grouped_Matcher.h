@@ -0,0 +1,92 @@
+#ifndef GROUPED_MATCHER_H
+#define GROUPED_MATCHER_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Compile_Limits.h"
+#include "DFA_Matcher.h"
+#include "Position_Automaton.h"
+
+/*
+ * A matcher for a set of patterns whose combined DFA would be too large.
+ *
+ * The patterns, split into their top level alternatives, are merged into
+ * groups in order. Each alternative joins the current group's union DFA
+ * unless the union's construction passes the group state budget, in
+ * which case the alternative starts a new group. The union of a few
+ * patterns that blow up when combined is thus never built past the
+ * budget, and the groups are as few as the budget allows. An alternative
+ * whose DFA alone passes the budget is not compiled to a DFA: its
+ * position automaton is simulated instead, one set of positions per
+ * byte, so no pattern makes the whole set fail.
+ *
+ * Matching steps every group's DFA over each byte in one pass over the
+ * input, so memory is bounded by the budget per group and throughput is
+ * close to a single DFA's when the groups are few.
+ */
+class Grouped_Matcher
+{
+  public:
+
+    /*
+     * ACCEPT matches whole inputs, SEARCH substrings
+     */
+    enum class Mode {ACCEPT, SEARCH};
+
+  private:
+
+    Mode mode;
+
+    // One matcher per group, all with the same table width
+    std::vector<std::unique_ptr<DFA_Matcher>> groups;
+
+    // The alternatives too large for a group on their own
+    std::vector<Position_Automaton> simulated;
+
+    /*
+     * The matching loop over tables of each width. match() picks one
+     * per call, not per byte.
+     */
+    template <typename State_T>
+    bool match(std::string_view input) const;
+
+  public:
+
+    /*
+     * Compiles the patterns into groups of at most max_group_states DFA
+     * states. max_time and the token of limits apply to each DFA built.
+     * Throws std::runtime_error if a pattern is invalid, and
+     * Compile_Limit_Error if the compilation runs out of time or is
+     * cancelled.
+     */
+    Grouped_Matcher(const std::vector<std::string>& patterns, Mode mode,
+        size_t max_group_states,
+        const Compile_Limits& limits = Compile_Limits());
+
+    /*
+     * Returns true iff some pattern recognizes the whole input (ACCEPT)
+     * or a substring of it (SEARCH)
+     */
+    bool match(std::string_view input) const;
+
+    /*
+     * Returns the number of groups
+     */
+    size_t group_count() const { return groups.size(); }
+
+    /*
+     * Returns the number of alternatives matched by simulation
+     */
+    size_t simulated_count() const { return simulated.size(); }
+
+    /*
+     * Returns the number of bytes used by the groups' tables and the
+     * simulated automata
+     */
+    size_t memory_usage() const;
+};
+
+#endif
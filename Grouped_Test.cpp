@@ -0,0 +1,89 @@
+/*
+ * Checks that a Grouped_Matcher handles a pattern whose DFA blows up on
+ * its own, with and without a pattern that fits a group
+ */
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Grouped_Matcher.h"
+
+using namespace std;
+
+static const int INPUTS {20000};
+static const size_t MAX_LENGTH {40};
+static const size_t GROUP_STATES {10000};
+
+// Characters after the a of .*a.{20}, which needs 2^21 DFA states
+static const size_t TAIL {20};
+
+/*
+ * Returns true iff the input has an a followed by TAIL printable
+ * characters, or, if anchored, is all printable and ends with such an a
+ */
+static bool expected(string_view input, bool anchored)
+{
+  size_t run {0};
+  for (size_t i {0}; i < input.size(); i++)
+  {
+    run = input[i] >= '!' && input[i] <= '~' ? run + 1 : 0;
+    if (run <= TAIL || input[i - TAIL] != 'a')
+      continue;
+
+    if (!anchored || (i + 1 == input.size() && run == input.size()))
+      return true;
+  }
+
+  return false;
+}
+
+int main()
+{
+  string exponential {"[!-~]*a"};
+  for (size_t i {0}; i < TAIL; i++)
+  {
+    exponential += "[!-~]";
+  }
+
+  typedef Grouped_Matcher::Mode Mode;
+  Grouped_Matcher accept {{exponential}, Mode::ACCEPT, GROUP_STATES};
+  Grouped_Matcher search {{exponential}, Mode::SEARCH, GROUP_STATES};
+  Grouped_Matcher mixed {{exponential, "zz"}, Mode::SEARCH, GROUP_STATES};
+
+  if (accept.simulated_count() != 1 || mixed.group_count() != 1)
+  {
+    cerr << "The exponential pattern was not simulated on its own" << endl;
+    return 1;
+  }
+
+  string chars {"abab  z~"};
+  mt19937 rng {1};
+  int matched {0};
+  for (int i {0}; i < INPUTS; i++)
+  {
+    string input;
+    size_t length {rng() % (MAX_LENGTH + 1)};
+    for (size_t j {0}; j < length; j++)
+    {
+      input += chars[rng() % chars.size()];
+    }
+
+    bool found {expected(input, false)};
+    if (accept.match(input) != expected(input, true) ||
+        search.match(input) != found ||
+        mixed.match(input) != (found || input.find("zz") != string::npos))
+    {
+      cerr << "Grouped matcher disagrees on \"" << input << "\"" << endl;
+      return 1;
+    }
+
+    matched += found;
+  }
+
+  cout << INPUTS << " inputs, " << matched << " matched, no mismatches"
+    << endl;
+  return 0;
+}
@@ -0,0 +1,351 @@
+/*
+ * Lexer implementation file
+ */
+
+#include <cstring>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Compile_Limits.h"
+#include "Lexer.h"
+#include "Position_Automaton.h"
+#include "Regex_AST.h"
+#include "Regex_Optimizer.h"
+#include "Regex_Parser.h"
+
+using namespace std;
+
+typedef Regex_Node::Type Type;
+
+static const char ALPHABET_START {' '};
+static const char ALPHABET_END {'~'};
+
+const int Lexer::END_OF_INPUT {-1};
+const int Lexer::ERROR {-2};
+
+const uint32_t Lexer::DEAD {0};
+const uint32_t Lexer::START {1};
+
+/*
+ * Returns the number of character leaves in a tree
+ */
+static size_t count_positions(const Regex_Node& node)
+{
+  size_t ret {node.type == Type::CHARACTER ? size_t {1} : 0};
+  for (auto& child : node.children)
+  {
+    ret += count_positions(*child);
+  }
+
+  return ret;
+}
+
+Lexer::Lexer(const vector<Rule>& rules, const Compile_Limits& limits)
+{
+  Compile_Budget budget {limits};
+  if (rules.empty())
+  {
+    throw runtime_error("Lexer has no rules");
+  }
+
+  /*
+   * Build (rule_0 #0)|(rule_1 #1)|... where marker #i is a position that
+   * matches no character. A set of positions containing #i has just
+   * matched rule i. Positions are numbered left to right, so the
+   * markers are in rule order.
+   */
+  auto tree {std::make_unique<Regex_Node>(Type::ALTERNATION)};
+  vector<size_t> markers;
+  size_t positions {0};
+
+  for (auto& rule : rules)
+  {
+    if (rule.token < 0)
+    {
+      throw runtime_error("Token ids must not be negative");
+    }
+
+    auto rule_tree {Regex_Optimizer::optimize(
+        Regex_Parser::regex_to_ast(rule.pattern))};
+
+    if (rule_tree->nullable())
+    {
+      throw runtime_error("Rule " + rule.pattern +
+          " matches the empty string");
+    }
+
+    positions += count_positions(*rule_tree);
+    markers.push_back(positions++);
+
+    tree->children.push_back(std::make_unique<Regex_Node>(
+        Type::CONCATENATION, std::move(rule_tree),
+        std::make_unique<Regex_Node>(Char_Set())));
+  }
+
+  Position_Automaton automaton {*tree};
+  vector<int> marker_token(automaton.size(), ERROR);
+  for (size_t i {0}; i < rules.size(); i++)
+  {
+    marker_token[markers[i]] = rules[i].token;
+  }
+
+  /*
+   * Subset construction over sets of positions, labeling each state
+   * with the first rule it accepts. State 0 is the empty set. This is
+   * DFA's construction from a Position_Automaton, with labels in place
+   * of a single accepting set, and it checks the budget the same way.
+   */
+  unordered_map<Position_Set, uint32_t> ids;
+  vector<Position_Set> sets;
+  vector<int> labels;
+
+  auto add_state = [&](const Position_Set& set)
+  {
+    auto ret {ids.emplace(set, sets.size())};
+    if (ret.second)
+    {
+      int label {ERROR};
+      set.for_each([&](size_t p)
+      {
+        if (label == ERROR)
+          label = marker_token[p];
+      });
+
+      sets.push_back(set);
+      labels.push_back(label);
+      budget.check(sets.size());
+    }
+
+    return ret.first->second;
+  };
+
+  add_state(Position_Set(automaton.size()));
+  add_state(automaton.get_first());
+
+  // Transitions over the alphabet, ALPHABET_END + 1 per state
+  const size_t width {ALPHABET_END + 1};
+  vector<uint32_t> moves;
+  vector<Position_Set> dst_sets(width, Position_Set(automaton.size()));
+
+  for (size_t state {0}; state < sets.size(); state++)
+  {
+    for (auto& dst_set : dst_sets)
+    {
+      dst_set.clear();
+    }
+
+    sets[state].for_each([&](size_t p)
+    {
+      const auto& chars {automaton.get_chars(p)};
+      for (char c {ALPHABET_START}; c <= ALPHABET_END; c++)
+      {
+        if (chars.test(c))
+          dst_sets[c] |= automaton.get_follow(p);
+      }
+    });
+
+    moves.resize(sets.size() * width, DEAD);
+    for (char c {ALPHABET_START}; c <= ALPHABET_END; c++)
+    {
+      uint32_t dst {add_state(dst_sets[c])};
+      moves.resize(sets.size() * width, DEAD);
+      moves[state * width + c] = dst;
+    }
+  }
+
+  size_t states {sets.size()};
+
+  /*
+   * Moore's partition refinement, starting from the states' labels so
+   * states accepting different tokens are never merged
+   */
+  vector<uint32_t> block(states);
+  size_t blocks {0};
+  {
+    map<int, uint32_t> label_blocks;
+    for (size_t s {0}; s < states; s++)
+    {
+      block[s] = label_blocks.emplace(labels[s], label_blocks.size())
+        .first->second;
+    }
+
+    blocks = label_blocks.size();
+  }
+
+  while (true)
+  {
+    budget.check(states);
+    map<vector<uint32_t>, uint32_t> signatures;
+    vector<uint32_t> next(states);
+    for (size_t s {0}; s < states; s++)
+    {
+      vector<uint32_t> signature {block[s]};
+      for (char c {ALPHABET_START}; c <= ALPHABET_END; c++)
+      {
+        signature.push_back(block[moves[s * width + c]]);
+      }
+
+      next[s] = signatures.emplace(signature, signatures.size())
+        .first->second;
+    }
+
+    block = next;
+    if (signatures.size() == blocks)
+      break;
+
+    blocks = signatures.size();
+  }
+
+  // Number the blocks: the dead state's first, then the start state's
+  const uint32_t NONE {static_cast<uint32_t>(blocks)};
+  vector<uint32_t> id(blocks, NONE);
+  uint32_t ids_used {0};
+  id[block[DEAD]] = ids_used++;
+  id[block[START]] = ids_used++;
+  for (size_t s {0}; s < states; s++)
+  {
+    if (id[block[s]] == NONE)
+      id[block[s]] = ids_used++;
+  }
+
+  token.assign(blocks, ERROR);
+  vector<vector<uint32_t>> columns(width, vector<uint32_t>(blocks, DEAD));
+  for (size_t s {0}; s < states; s++)
+  {
+    token[id[block[s]]] = labels[s];
+    for (char c {ALPHABET_START}; c <= ALPHABET_END; c++)
+    {
+      columns[c][id[block[s]]] = id[block[moves[s * width + c]]];
+    }
+  }
+
+  // Characters with identical columns share a class, class 0 being dead
+  map<vector<uint32_t>, uint8_t> classes {
+    {vector<uint32_t>(blocks, DEAD), 0}};
+
+  byte_class.fill(0);
+  for (char c {ALPHABET_START}; c <= ALPHABET_END; c++)
+  {
+    auto it {classes.emplace(columns[c], classes.size()).first};
+    byte_class[static_cast<unsigned char>(c)] = it->second;
+  }
+
+  class_count = classes.size();
+  table.assign(blocks * class_count, DEAD);
+  for (char c {ALPHABET_START}; c <= ALPHABET_END; c++)
+  {
+    unsigned cls {byte_class[static_cast<unsigned char>(c)]};
+    for (size_t state {0}; state < blocks; state++)
+    {
+      table[state * class_count + cls] = columns[c][state];
+    }
+  }
+}
+
+Token Lexer::next(string_view input, size_t offset) const
+{
+  if (offset >= input.size())
+  {
+    return {END_OF_INPUT, input.substr(input.size()), input.size()};
+  }
+
+  // Step until the DFA dies, remembering the last accepting position
+  uint32_t state {START};
+  int id {ERROR};
+  size_t length {1};
+
+  for (size_t i {offset}; i < input.size(); i++)
+  {
+    state = delta(state, input[i]);
+    if (state == DEAD)
+      break;
+
+    if (token[state] != ERROR)
+    {
+      id = token[state];
+      length = i + 1 - offset;
+    }
+  }
+
+  return {id, input.substr(offset, length), offset};
+}
+
+Token_Stream::Token_Stream(const Lexer& l, Reader reader,
+    size_t buffer_size) :
+  lexer(l), read(reader), buffer(buffer_size > 0 ? buffer_size : 1),
+  begin(0), end(0), end_of_input(false), offset(0)
+{
+}
+
+bool Token_Stream::fill()
+{
+  if (end_of_input)
+  {
+    return false;
+  }
+
+  // Keep the token being scanned, growing the buffer if it fills it
+  if (begin > 0)
+  {
+    memmove(buffer.data(), buffer.data() + begin, end - begin);
+    end -= begin;
+    begin = 0;
+  }
+
+  if (end == buffer.size())
+  {
+    buffer.resize(buffer.size() * 2);
+  }
+
+  size_t count {read(buffer.data() + end, buffer.size() - end)};
+  if (count == 0)
+  {
+    end_of_input = true;
+    return false;
+  }
+
+  end += count;
+  return true;
+}
+
+Token Token_Stream::next()
+{
+  if (begin == end && !fill())
+  {
+    return {Lexer::END_OF_INPUT, string_view(), offset};
+  }
+
+  uint32_t state {lexer.get_start_state()};
+  int id {Lexer::ERROR};
+  size_t length {1};
+
+  // Positions are relative to begin, which fill() may move
+  size_t i {0};
+  while (true)
+  {
+    for (; begin + i < end; i++)
+    {
+      state = lexer.delta(state, buffer[begin + i]);
+      if (lexer.is_dead(state))
+        break;
+
+      if (lexer.accepted(state) != Lexer::ERROR)
+      {
+        id = lexer.accepted(state);
+        length = i + 1;
+      }
+    }
+
+    if (begin + i < end || !fill())
+      break;
+  }
+
+  Token ret {id, string_view(buffer.data() + begin, length), offset};
+  begin += length;
+  offset += length;
+  return ret;
+}
@@ -0,0 +1,154 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Compile_Limits.h"
+
+/*
+ * A token scanned by a Lexer
+ */
+class Token
+{
+  public:
+    // The id of the rule that matched, END_OF_INPUT or ERROR
+    int id;
+
+    // The token's text, in the scanned input or the stream's buffer
+    std::string_view text;
+
+    // Offset of the token from the beginning of the input
+    size_t offset;
+};
+
+/*
+ * A maximal munch scanner built from an ordered list of rules.
+ *
+ * All rules are compiled into one DFA whose accepting states are labeled
+ * with the first rule they accept. Scanning steps the DFA until it dies,
+ * remembering the last accepting position, so the longest match wins and
+ * ties go to the earliest rule. The lexer is immutable and can be shared
+ * by any number of threads.
+ */
+class Lexer
+{
+  public:
+
+    // A pattern and the token id it produces, at least 0
+    class Rule
+    {
+      public:
+        std::string pattern;
+        int token;
+    };
+
+    /*
+     * Ids of the tokens returned at the end of the input, and for a byte
+     * no rule matches
+     */
+    static const int END_OF_INPUT;
+    static const int ERROR;
+
+  private:
+
+    static const uint32_t DEAD;
+    static const uint32_t START;
+
+    // The equivalence class of each byte
+    std::array<uint8_t, 256> byte_class;
+
+    unsigned class_count;
+
+    // Transition table, indexed by state * class_count + class
+    std::vector<uint32_t> table;
+
+    // The token accepted in each state, or ERROR
+    std::vector<int> token;
+
+  public:
+
+    /*
+     * Compiles the rules, earlier rules having priority.
+     * Throws std::runtime_error if a pattern is invalid or matches the
+     * empty string, and Compile_Limit_Error if the DFA goes over the
+     * limits.
+     */
+    Lexer(const std::vector<Rule>& rules,
+        const Compile_Limits& limits = Compile_Limits());
+
+    uint32_t delta(uint32_t state, unsigned char c) const
+    {
+      return table[state * class_count + byte_class[c]];
+    }
+
+    uint32_t get_start_state() const { return START; }
+    bool is_dead(uint32_t state) const { return state == DEAD; }
+
+    /*
+     * Returns the token accepted in a state, or ERROR
+     */
+    int accepted(uint32_t state) const { return token[state]; }
+
+    /*
+     * Scans the longest token of input starting at offset. A byte that
+     * starts no token is returned alone as an ERROR token.
+     */
+    Token next(std::string_view input, size_t offset) const;
+
+    /*
+     * Returns the number of states, including the dead state
+     */
+    size_t size() const { return token.size(); }
+};
+
+/*
+ * Scans the tokens of an input read in chunks into a refillable buffer.
+ * Token text points into the buffer and stays valid until the next call
+ * to next(). The buffer grows only when a single token outgrows it.
+ */
+class Token_Stream
+{
+  public:
+
+    /*
+     * Reads up to size bytes into buffer, returning the number read.
+     * 0 is the end of the input.
+     */
+    typedef std::function<size_t(char* buffer, size_t size)> Reader;
+
+  private:
+    const Lexer& lexer;
+    Reader read;
+
+    // The unscanned input is buffer[begin, end)
+    std::vector<char> buffer;
+    size_t begin;
+    size_t end;
+    bool end_of_input;
+
+    // Offset of buffer[begin] in the input
+    size_t offset;
+
+    /*
+     * Moves the unscanned input to the front of the buffer and reads
+     * more after it. Returns false at the end of the input.
+     */
+    bool fill();
+
+  public:
+    Token_Stream(const Lexer& lexer, Reader reader,
+        size_t buffer_size = 4096);
+
+    /*
+     * Scans the next token. Returns END_OF_INPUT once the input is
+     * consumed.
+     */
+    Token next();
+};
+
+#endif
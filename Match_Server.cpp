@@ -0,0 +1,414 @@
+/*
+ * Match_Server implementation file
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "DFA_Matcher.h"
+#include "Match_Server.h"
+
+using namespace std;
+
+const uint32_t Match_Server::MAX_REQUEST_SIZE {64 << 20};
+
+// epoll ids of the listening socket and the wake up event
+static const uint64_t LISTEN_ID {0};
+static const uint64_t WAKE_ID {1};
+
+// Bytes read from a connection at a time
+static const size_t READ_SIZE {64 << 10};
+
+static uint32_t get_u32(const char* p)
+{
+  auto b {reinterpret_cast<const unsigned char*>(p)};
+  return b[0] | b[1] << 8 | b[2] << 16 | static_cast<uint32_t>(b[3]) << 24;
+}
+
+static void put_u32(string& out, uint32_t x)
+{
+  for (int i {0}; i < 4; i++)
+  {
+    out += static_cast<char>(x >> (8 * i));
+  }
+}
+
+static runtime_error os_error(const string& what)
+{
+  return runtime_error(what + ": " + strerror(errno));
+}
+
+Match_Server::Match_Server(vector<unique_ptr<DFA_Matcher>> m,
+    unsigned thread_count) :
+  matchers(std::move(m)), threads(thread_count), next_id(WAKE_ID + 1)
+{
+  if (threads == 0)
+  {
+    threads = max(1u, thread::hardware_concurrency());
+  }
+
+  wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (wake_fd < 0)
+  {
+    throw os_error("eventfd");
+  }
+}
+
+Match_Server::~Match_Server()
+{
+  close(wake_fd);
+}
+
+void Match_Server::stop()
+{
+  {
+    lock_guard<std::mutex> lock {mutex};
+    stopping = true;
+  }
+
+  uint64_t one {1};
+  (void)!write(wake_fd, &one, sizeof(one));
+}
+
+void Match_Server::serve(const string& path)
+{
+  sockaddr_un address {};
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path))
+  {
+    throw runtime_error("Socket path too long: " + path);
+  }
+
+  path.copy(address.sun_path, path.size());
+
+  // Replace a socket left behind by an earlier server, but nothing else
+  struct stat info;
+  if (stat(path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode))
+  {
+    unlink(path.c_str());
+  }
+
+  listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (listen_fd < 0)
+  {
+    throw os_error("socket");
+  }
+
+  epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (bind(listen_fd, reinterpret_cast<sockaddr*>(&address),
+        sizeof(address)) != 0 || listen(listen_fd, SOMAXCONN) != 0 ||
+      epoll_fd < 0)
+  {
+    auto error {os_error(path)};
+    close(listen_fd);
+    if (epoll_fd >= 0)
+      close(epoll_fd);
+    throw error;
+  }
+
+  epoll_event event {};
+  event.events = EPOLLIN;
+  event.data.u64 = LISTEN_ID;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event);
+  event.data.u64 = WAKE_ID;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event);
+
+  vector<thread> workers;
+  for (unsigned i {0}; i < threads; i++)
+  {
+    workers.emplace_back(&Match_Server::work, this);
+  }
+
+  epoll_event events[64];
+  for (bool running {true}; running;)
+  {
+    int n {epoll_wait(epoll_fd, events, 64, -1)};
+    for (int i {0}; i < n; i++)
+    {
+      auto id {events[i].data.u64};
+      if (id == LISTEN_ID)
+      {
+        accept_connections();
+      }
+      else if (id == WAKE_ID)
+      {
+        uint64_t count;
+        (void)!read(wake_fd, &count, sizeof(count));
+
+        lock_guard<std::mutex> lock {mutex};
+        running = !stopping;
+      }
+      else if (connections.count(id) != 0)
+      {
+        receive(id);
+
+        auto it {connections.find(id)};
+        if (it != connections.end())
+          flush(id, it->second);
+      }
+    }
+
+    finish_batches();
+  }
+
+  // Let the workers drain, then drop everything
+  work_ready.notify_all();
+  for (auto& worker : workers)
+  {
+    worker.join();
+  }
+
+  while (!connections.empty())
+  {
+    close_connection(connections.begin()->first);
+  }
+
+  pending.clear();
+  done.clear();
+  stopping = false;
+  close(listen_fd);
+  close(epoll_fd);
+  unlink(path.c_str());
+}
+
+void Match_Server::accept_connections()
+{
+  for (;;)
+  {
+    int fd {accept4(listen_fd, nullptr, nullptr,
+        SOCK_NONBLOCK | SOCK_CLOEXEC)};
+    if (fd < 0)
+      return;
+
+    auto id {next_id++};
+    connections[id].fd = fd;
+
+    epoll_event event {};
+    event.events = EPOLLIN;
+    event.data.u64 = id;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+  }
+}
+
+void Match_Server::receive(uint64_t id)
+{
+  auto& connection {connections.at(id)};
+  char buffer[READ_SIZE];
+
+  // Stop reading ahead of the workers once a whole request is buffered
+  while (connection.in.size() < 4 + MAX_REQUEST_SIZE)
+  {
+    auto n {read(connection.fd, buffer, sizeof(buffer))};
+    if (n > 0)
+    {
+      connection.in.append(buffer, n);
+      continue;
+    }
+
+    if (n == 0 || (errno != EAGAIN && errno != EINTR))
+    {
+      connection.eof = true;
+
+      // Nothing more will be read
+      epoll_ctl(epoll_fd, EPOLL_CTL_DEL, connection.fd, nullptr);
+    }
+
+    if (n == 0 || errno != EINTR)
+      break;
+  }
+
+  dispatch(id, connection);
+}
+
+void Match_Server::dispatch(uint64_t id, Connection& connection)
+{
+  if (connection.busy || connection.in.size() < 4)
+    return;
+
+  uint32_t length {get_u32(connection.in.data())};
+  if (length > MAX_REQUEST_SIZE)
+  {
+    // Drop the rest, and close once the replies are sent
+    connection.in.clear();
+    connection.eof = true;
+    return;
+  }
+
+  if (connection.in.size() - 4 < length)
+    return;
+
+  Batch batch {id, connection.in.substr(4, length), {}};
+  connection.in.erase(0, 4 + length);
+  connection.busy = true;
+
+  {
+    lock_guard<std::mutex> lock {mutex};
+    pending.push_back(std::move(batch));
+  }
+
+  work_ready.notify_one();
+}
+
+void Match_Server::finish_batches()
+{
+  vector<Batch> finished;
+  {
+    lock_guard<std::mutex> lock {mutex};
+    finished.swap(done);
+  }
+
+  for (auto& batch : finished)
+  {
+    // The connection may be gone
+    auto it {connections.find(batch.connection)};
+    if (it == connections.end())
+      continue;
+
+    auto& connection {it->second};
+    connection.busy = false;
+    if (batch.reply.empty())
+    {
+      close_connection(batch.connection);
+      continue;
+    }
+
+    connection.out += batch.reply;
+    dispatch(batch.connection, connection);
+    flush(batch.connection, connection);
+  }
+}
+
+bool Match_Server::flush(uint64_t id, Connection& connection)
+{
+  while (!connection.out.empty())
+  {
+    auto n {send(connection.fd, connection.out.data(), connection.out.size(),
+        MSG_NOSIGNAL)};
+    if (n < 0 && errno == EINTR)
+      continue;
+
+    if (n < 0 && errno == EAGAIN)
+      break;
+
+    if (n < 0)
+    {
+      close_connection(id);
+      return false;
+    }
+
+    connection.out.erase(0, n);
+  }
+
+  // Done once the client stopped sending and every reply is out
+  if (connection.eof && !connection.busy && connection.out.empty())
+  {
+    close_connection(id);
+    return false;
+  }
+
+  // Wait for room to send the rest, or for more requests
+  bool reading {!connection.eof &&
+    connection.in.size() < 4 + MAX_REQUEST_SIZE};
+
+  epoll_event event {};
+  event.events = (reading ? uint32_t {EPOLLIN} : uint32_t {0}) |
+    (connection.out.empty() ? uint32_t {0} : uint32_t {EPOLLOUT});
+  event.data.u64 = id;
+  if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection.fd, &event) != 0 &&
+      event.events != 0)
+  {
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, connection.fd, &event);
+  }
+
+  return true;
+}
+
+void Match_Server::close_connection(uint64_t id)
+{
+  auto it {connections.find(id)};
+  if (it == connections.end())
+    return;
+
+  // Closing removes the socket from the epoll set
+  close(it->second.fd);
+  connections.erase(it);
+}
+
+string Match_Server::match(const string& request) const
+{
+  if (request.size() < 4)
+    return "";
+
+  // A request holds at least 8 bytes per pair, so a count too large for
+  // the request is rejected before the reply is sized by it
+  uint32_t count {get_u32(request.data())};
+  if (count > (request.size() - 4) / 8)
+    return "";
+
+  string reply;
+  put_u32(reply, count);
+  reply.resize(4 + (count + 7) / 8);
+
+  size_t offset {4};
+  for (uint32_t i {0}; i < count; i++)
+  {
+    if (request.size() - offset < 8)
+      return "";
+
+    uint32_t pattern {get_u32(request.data() + offset)};
+    uint32_t length {get_u32(request.data() + offset + 4)};
+    offset += 8;
+
+    if (pattern >= matchers.size() || request.size() - offset < length)
+      return "";
+
+    string_view input {request.data() + offset, length};
+    offset += length;
+
+    if (matchers[pattern]->accept(input))
+    {
+      reply[4 + i / 8] |= 1 << (i % 8);
+    }
+  }
+
+  return offset == request.size() ? reply : "";
+}
+
+void Match_Server::work()
+{
+  for (;;)
+  {
+    Batch batch;
+    {
+      unique_lock<std::mutex> lock {mutex};
+      work_ready.wait(lock, [&]() { return stopping || !pending.empty(); });
+      if (stopping)
+        return;
+
+      batch = std::move(pending.front());
+      pending.pop_front();
+    }
+
+    batch.reply = match(batch.request);
+
+    {
+      lock_guard<std::mutex> lock {mutex};
+      done.push_back(std::move(batch));
+    }
+
+    uint64_t one {1};
+    (void)!write(wake_fd, &one, sizeof(one));
+  }
+}
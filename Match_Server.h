@@ -0,0 +1,150 @@
+#ifndef MATCH_SERVER_H
+#define MATCH_SERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "DFA_Matcher.h"
+
+/*
+ * A server matching batches of inputs against resident patterns over a
+ * Unix domain socket, so clients pay neither process startup nor pattern
+ * compilation per request.
+ *
+ * Patterns are numbered by their position in the server's list. Every
+ * integer is an unsigned 32 bit little endian value. A request is
+ *
+ *   length, count, then count times: pattern id, input length, input
+ *
+ * where length is the number of bytes after it. The reply is
+ *
+ *   count, then (count + 7) / 8 bytes of bits
+ *
+ * where bit i % 8 of byte i / 8 is set iff pattern i accepts input i.
+ * A client may send several requests without waiting; replies come back
+ * in order. Malformed requests close the connection.
+ *
+ * One thread runs an epoll event loop over the connections, and a pool
+ * of worker threads matches the batches.
+ */
+class Match_Server
+{
+  private:
+
+    // A client connection
+    class Connection
+    {
+      public:
+        int fd;
+
+        // Bytes received and not yet handed to the workers
+        std::string in;
+
+        // Reply bytes not yet sent
+        std::string out;
+
+        // A batch of the connection is with the workers
+        bool busy {false};
+
+        // The client is done sending
+        bool eof {false};
+    };
+
+    // A request handed to the workers
+    class Batch
+    {
+      public:
+        uint64_t connection;
+        std::string request;
+
+        // The reply, empty if the request is malformed
+        std::string reply;
+    };
+
+    std::vector<std::unique_ptr<DFA_Matcher>> matchers;
+    unsigned threads;
+
+    int epoll_fd {-1};
+    int listen_fd {-1};
+
+    // Wakes the event loop when batches are done or on stop()
+    int wake_fd {-1};
+
+    // Connections by id, which are never reused
+    std::unordered_map<uint64_t, Connection> connections;
+    uint64_t next_id;
+
+    std::mutex mutex;
+    std::condition_variable work_ready;
+    std::deque<Batch> pending;
+    std::vector<Batch> done;
+    bool stopping {false};
+
+    /*
+     * Event loop handlers
+     */
+    void accept_connections();
+    void receive(uint64_t id);
+    void finish_batches();
+
+    /*
+     * Hands the connection's next complete request to the workers
+     */
+    void dispatch(uint64_t id, Connection& connection);
+
+    /*
+     * Sends what it can of the connection's reply bytes, and closes it if
+     * it has nothing left to do. Returns false if it was closed.
+     */
+    bool flush(uint64_t id, Connection& connection);
+
+    void close_connection(uint64_t id);
+
+    /*
+     * Matches a request, returning its reply or an empty string if it is
+     * malformed
+     */
+    std::string match(const std::string& request) const;
+
+    /*
+     * Worker thread body
+     */
+    void work();
+
+  public:
+
+    /*
+     * Largest request accepted, in bytes
+     */
+    static const uint32_t MAX_REQUEST_SIZE;
+
+    /*
+     * Constructs a server for the matchers, using threads worker threads,
+     * 0 for one per hardware thread
+     */
+    Match_Server(std::vector<std::unique_ptr<DFA_Matcher>> matchers,
+        unsigned threads = 0);
+    ~Match_Server();
+
+    /*
+     * Listens on a Unix domain socket at path and serves clients until
+     * stop() is called. A stale socket at path is replaced.
+     * Throws std::runtime_error if the socket can't be set up.
+     */
+    void serve(const std::string& path);
+
+    /*
+     * Makes serve() return. Can be called from any thread.
+     */
+    void stop();
+};
+
+#endif
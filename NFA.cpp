@@ -4,6 +4,7 @@
 
 #include <deque>
 #include <climits>
+#include <memory_resource>
 
 #include "NFA.h"
 #include "NFA_Transition.h"
@@ -27,6 +28,24 @@ NFA::NFA(char c)
   final_state_id = transition.dst_node_id;
 }
 
+NFA::NFA(const Char_Set& set)
+{
+  start_state_id = 0;
+  final_state_id = 1;
+
+  // One transition from the start state per character in the set
+  state_map.push_back({});
+  for (size_t c {0}; c < set.size(); c++)
+  {
+    if (set.test(c))
+    {
+      state_map.back().push_back({static_cast<char>(c), final_state_id});
+    }
+  }
+
+  state_map.push_back({});
+}
+
 void NFA::concatenate(const unique_ptr<NFA>& other)
 {
   unsigned size_offset {static_cast<unsigned>(state_map.size())};
@@ -147,3 +166,61 @@ unordered_set<unsigned> NFA::epsilon_closure(unsigned init_state) const
 
   return result;
 }
+
+void NFA::epsilon_closure(unsigned init_state,
+    pmr::unordered_set<unsigned>& closure) const
+{
+  if (!closure.insert(init_state).second)
+    return;
+
+  pmr::vector<unsigned> work_list({init_state}, closure.get_allocator());
+  while (!work_list.empty())
+  {
+    auto current_state {work_list.back()};
+    work_list.pop_back();
+
+    for (auto& t : state_map[current_state])
+    {
+      // Enqueue the states epsilon transitions reach for the first time
+      if (t.character == EPSILON && closure.insert(t.dst_node_id).second)
+        work_list.push_back(t.dst_node_id);
+    }
+  }
+}
+
+bool NFA::accept(const string& to_accept) const
+{
+  auto curr_states {epsilon_closure(start_state_id)};
+
+  for (auto c : to_accept)
+  {
+    // Input characters never match epsilon transitions
+    if (c == EPSILON)
+    {
+      return false;
+    }
+
+    // Step every state over c, then take the epsilon closure
+    unordered_set<unsigned> next_states;
+    for (auto state : curr_states)
+    {
+      auto dst {delta(state, c)};
+      if (dst != ERROR && next_states.find(dst) == next_states.end())
+      {
+        for (auto x : epsilon_closure(dst))
+        {
+          next_states.emplace(x);
+        }
+      }
+    }
+
+    if (next_states.empty())
+    {
+      return false;
+    }
+
+    curr_states = std::move(next_states);
+  }
+
+  return curr_states.find(final_state_id) != curr_states.end();
+}
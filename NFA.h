@@ -2,21 +2,30 @@
 #define NFA_H
 
 #include <memory>
+#include <memory_resource>
 #include <vector>
 #include <list>
 #include <unordered_set>
+#include <string>
 
 #include "NFA_Transition.h"
+#include "Char_Set.h"
 
 /*
  * A class representing an NFA.
+ * An NFA only lives while a pattern is compiled, so its many small
+ * transition list nodes come from an arena owned by the NFA and are
+ * released together with it.
  */
 class NFA
 {
   private:
 
+    // Memory for the adjacency lists
+    std::pmr::monotonic_buffer_resource arena;
+
     // NFA adjacency lists representation
-    std::vector<std::list<NFA_Transition>> state_map;
+    std::pmr::vector<std::pmr::list<NFA_Transition>> state_map {&arena};
 
     // The NFA's final state
     unsigned final_state_id;
@@ -32,6 +41,11 @@ class NFA
      * Constructs a trivial NFA accepting one character
      */
     NFA(char c);
+
+    /*
+     * Constructs a trivial NFA accepting any one character in a set
+     */
+    NFA(const Char_Set& set);
     
     /*
      * Construct an NFA corresponding to the disjunction of both operands'
@@ -64,7 +78,23 @@ class NFA
      * Returns the set of states reachable by 0 or more epsilon transitions
      */
     std::unordered_set<unsigned> epsilon_closure(unsigned initial_state) const;
+
+    /*
+     * Adds the states reachable by 0 or more epsilon transitions to
+     * closure, allocating from closure's memory resource. States already
+     * in closure are taken to have their own closures in it.
+     */
+    void epsilon_closure(unsigned initial_state,
+        std::pmr::unordered_set<unsigned>& closure) const;
+
+    /*
+     * Checks if a given string can be accepted by the NFA by simulating
+     * it on sets of states. Slower than a DFA, but needs no subset
+     * construction, so it works for patterns whose DFA is too large.
+     */
+    bool accept(const std::string& to_accept) const;
    
+    size_t size() const { return state_map.size(); }
     unsigned get_final_state_id() const { return final_state_id; }
     unsigned get_start_state_id() const { return start_state_id; }
 };
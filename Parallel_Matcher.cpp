@@ -0,0 +1,158 @@
+/*
+ * Parallel_Matcher implementation file
+ */
+
+#include <algorithm>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "DFA_Matcher.h"
+#include "Parallel_Matcher.h"
+
+using namespace std;
+
+const size_t Parallel_Matcher::MIN_CHUNK_SIZE {1 << 20};
+
+// Bytes between merges of the states running a chunk
+static const size_t MERGE_INTERVAL {64};
+
+/*
+ * Runs a chunk from every state. mapping[s] receives the state the chunk
+ * ends in when it begins in state s.
+ */
+template <typename Rows>
+static void map_chunk(const DFA_Matcher& matcher, Rows rows,
+    string_view chunk, vector<uint32_t>& mapping)
+{
+  size_t states {matcher.size()};
+
+  // The distinct live states, and the one each starting state is in
+  vector<uint32_t> current;
+  vector<uint32_t> slot(states);
+  for (uint32_t s {0}; s < states; s++)
+  {
+    slot[s] = current.size();
+    current.push_back(s);
+  }
+
+  // Slot each state moved to at the last merge, by state
+  vector<uint32_t> merged(states);
+  vector<uint32_t> remap;
+  const uint32_t NONE {static_cast<uint32_t>(states)};
+
+  size_t i {0};
+  while (i < chunk.size() && current.size() > 1)
+  {
+    size_t stop {min(chunk.size(), i + MERGE_INTERVAL)};
+    for (; i < stop; i++)
+    {
+      for (auto& state : current)
+      {
+        state = rows.delta(state, chunk[i]);
+      }
+    }
+
+    // Merge slots that reached the same state
+    fill(merged.begin(), merged.end(), NONE);
+    remap.resize(current.size());
+    size_t live {0};
+    for (size_t j {0}; j < current.size(); j++)
+    {
+      auto& target {merged[current[j]]};
+      if (target == NONE)
+      {
+        target = live;
+        current[live++] = current[j];
+      }
+
+      remap[j] = target;
+    }
+
+    if (live < current.size())
+    {
+      current.resize(live);
+      for (auto& s : slot)
+      {
+        s = remap[s];
+      }
+    }
+  }
+
+  // One state left: finish sequentially
+  if (current.size() == 1)
+  {
+    for (; i < chunk.size() && current[0] != DFA_Matcher::DEAD; i++)
+    {
+      current[0] = rows.delta(current[0], chunk[i]);
+    }
+  }
+
+  mapping.resize(states);
+  for (uint32_t s {0}; s < states; s++)
+  {
+    mapping[s] = current[slot[s]];
+  }
+}
+
+// map_chunk with the table width picked once for the chunk
+static void map_chunk_any(const DFA_Matcher& matcher, string_view chunk,
+    vector<uint32_t>& mapping)
+{
+  matcher.with_rows([&](auto rows)
+  {
+    map_chunk(matcher, rows, chunk, mapping);
+  });
+}
+
+bool Parallel_Matcher::accept(const DFA_Matcher& matcher, string_view input,
+    unsigned threads)
+{
+  if (threads == 0)
+  {
+    threads = max(1u, thread::hardware_concurrency());
+  }
+
+  size_t chunks {min<size_t>(threads, input.size() / MIN_CHUNK_SIZE)};
+  if (chunks <= 1)
+  {
+    return matcher.accept(input);
+  }
+
+  size_t chunk_size {input.size() / chunks};
+  vector<vector<uint32_t>> mappings(chunks);
+  vector<thread> workers;
+
+  for (size_t c {1}; c < chunks; c++)
+  {
+    size_t begin {c * chunk_size};
+    size_t end {c + 1 == chunks ? input.size() : begin + chunk_size};
+    workers.emplace_back(map_chunk_any, cref(matcher),
+        input.substr(begin, end - begin), ref(mappings[c]));
+  }
+
+  // Run the first chunk from the start state meanwhile
+  uint32_t state {matcher.with_rows([&](auto rows)
+  {
+    uint32_t s {matcher.get_start_state()};
+    for (size_t i {0}; i < chunk_size && s != DFA_Matcher::DEAD; i++)
+    {
+      s = rows.delta(s, input[i]);
+    }
+
+    return s;
+  })};
+
+  for (auto& worker : workers)
+  {
+    worker.join();
+  }
+
+  // Compose the mappings
+  for (size_t c {1}; c < chunks; c++)
+  {
+    state = mappings[c][state];
+  }
+
+  return matcher.is_accepting(state);
+}
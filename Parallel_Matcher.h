@@ -0,0 +1,45 @@
+#ifndef PARALLEL_MATCHER_H
+#define PARALLEL_MATCHER_H
+
+#include <string_view>
+
+#include "DFA_Matcher.h"
+
+/*
+ * A class that matches one large input on several threads.
+ *
+ * The input is split into one chunk per thread. The first chunk runs from
+ * the start state; the others can't know the state they begin in, so
+ * they run from every state at once and produce a mapping from the state
+ * a chunk begins in to the state it ends in. Composing the mappings in
+ * order gives the exact final state.
+ *
+ * Running from every state is cheap in practice: states that reach the
+ * same state merge and states that die are dropped, and most DFAs
+ * converge to a few states within a few bytes.
+ */
+class Parallel_Matcher
+{
+  private:
+
+    /*
+     * Private constructor
+     */
+    Parallel_Matcher() {}
+
+  public:
+
+    /*
+     * Inputs smaller than this are matched on the calling thread
+     */
+    static const size_t MIN_CHUNK_SIZE;
+
+    /*
+     * Returns true iff the matcher recognizes the whole input, using up
+     * to threads threads. 0 uses one per hardware thread.
+     */
+    static bool accept(const DFA_Matcher& matcher, std::string_view input,
+        unsigned threads = 0);
+};
+
+#endif
@@ -0,0 +1,116 @@
+/*
+ * Pattern_Cache implementation file
+ */
+
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "Pattern_Cache.h"
+#include "Regex_Compiler.h"
+#include "Regex_Parser.h"
+
+using namespace std;
+
+Pattern_Cache::Pattern_Cache(size_t budget,
+    const Compile_Limits& compile_limits, uint64_t threshold) :
+  memory_budget(budget), memory_used(0), limits(compile_limits),
+  jit_threshold(threshold), hit_count(0), miss_count(0)
+{
+}
+
+Pattern_Cache::Matcher_Ptr Pattern_Cache::get(const string& pattern)
+{
+  auto key {Regex_Parser::normalize(pattern)};
+  unique_lock<std::mutex> lock(mutex);
+
+  auto it {entries.find(key)};
+  if (it != entries.end())
+  {
+    // Hit. Mark the pattern as most recently used.
+    hit_count++;
+    lru.splice(lru.begin(), lru, it->second.lru_location);
+    auto matcher {it->second.matcher};
+
+    // Wait for a compilation in progress without holding the lock
+    lock.unlock();
+    return matcher.get();
+  }
+
+  // Miss. Publish the compilation so concurrent misses wait for it.
+  miss_count++;
+  promise<Matcher_Ptr> compiled;
+  lru.push_front(key);
+  entries[key] = {compiled.get_future().share(), 0, lru.begin()};
+  lock.unlock();
+
+  Matcher_Ptr matcher;
+  try
+  {
+    auto compiled_matcher {Regex_Compiler::compile(key, limits)};
+    compiled_matcher->set_jit_threshold(jit_threshold);
+    matcher = std::move(compiled_matcher);
+  }
+  catch (...)
+  {
+    // Don't cache failures; let the waiters see the error
+    compiled.set_exception(current_exception());
+
+    lock.lock();
+    it = entries.find(key);
+    lru.erase(it->second.lru_location);
+    entries.erase(it);
+    throw;
+  }
+
+  compiled.set_value(matcher);
+
+  lock.lock();
+  auto& entry {entries.at(key)};
+  entry.bytes = matcher->memory_usage();
+  memory_used += entry.bytes;
+  evict();
+
+  return matcher;
+}
+
+void Pattern_Cache::evict()
+{
+  auto it {lru.end()};
+  while (memory_used > memory_budget && it != lru.begin())
+  {
+    it--;
+
+    // Patterns still compiling have no size yet and can't be evicted
+    auto entry {entries.find(*it)};
+    if (entry->second.bytes == 0)
+    {
+      continue;
+    }
+
+    // Callers holding the matcher keep it alive after eviction
+    memory_used -= entry->second.bytes;
+    entries.erase(entry);
+    it = lru.erase(it);
+  }
+}
+
+void Pattern_Cache::set_memory_budget(size_t budget)
+{
+  lock_guard<std::mutex> lock(mutex);
+  memory_budget = budget;
+  evict();
+}
+
+size_t Pattern_Cache::memory_usage() const
+{
+  lock_guard<std::mutex> lock(mutex);
+  return memory_used;
+}
+
+size_t Pattern_Cache::size() const
+{
+  lock_guard<std::mutex> lock(mutex);
+  return entries.size();
+}
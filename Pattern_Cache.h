@@ -0,0 +1,110 @@
+#ifndef PATTERN_CACHE_H
+#define PATTERN_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "Compile_Limits.h"
+#include "DFA_Matcher.h"
+
+/*
+ * A thread safe cache of compiled patterns keyed on the normalized
+ * pattern text.
+ *
+ * The cache holds at most memory_budget bytes of matcher tables and
+ * evicts the least recently used patterns when it goes over. Concurrent
+ * misses on the same pattern compile it only once; the other callers
+ * wait for the first compilation to finish.
+ *
+ * With a JIT threshold, each pattern is compiled to native code once it
+ * has been used that many times.
+ */
+class Pattern_Cache
+{
+  public:
+    typedef std::shared_ptr<const DFA_Matcher> Matcher_Ptr;
+
+  private:
+
+    // A cached pattern
+    class Entry
+    {
+      public:
+        // The compiled matcher, or the compilation in progress
+        std::shared_future<Matcher_Ptr> matcher;
+
+        // Bytes used by the matcher's tables, 0 while compiling
+        size_t bytes;
+
+        // Location in the LRU list
+        std::list<std::string>::iterator lru_location;
+    };
+
+    mutable std::mutex mutex;
+
+    std::unordered_map<std::string, Entry> entries;
+
+    // Patterns from most to least recently used
+    std::list<std::string> lru;
+
+    size_t memory_budget;
+    size_t memory_used;
+
+    // Limits applied to every compilation
+    Compile_Limits limits;
+
+    // See DFA_Matcher::set_jit_threshold
+    uint64_t jit_threshold;
+
+    std::atomic<uint64_t> hit_count;
+    std::atomic<uint64_t> miss_count;
+
+    /*
+     * Evicts compiled patterns until the cache fits in its budget.
+     * The mutex must be held.
+     */
+    void evict();
+
+  public:
+
+    /*
+     * Constructs an empty cache holding at most memory_budget bytes of
+     * matcher tables
+     */
+    Pattern_Cache(size_t memory_budget,
+        const Compile_Limits& compile_limits = Compile_Limits(),
+        uint64_t jit_threshold = 0);
+
+    /*
+     * Returns the compiled matcher for a pattern, compiling it on a miss.
+     * Throws std::runtime_error if the pattern is invalid, and
+     * Compile_Limit_Error if it goes over the compile limits.
+     */
+    Matcher_Ptr get(const std::string& pattern);
+
+    /*
+     * Changes the memory budget, evicting patterns if needed
+     */
+    void set_memory_budget(size_t budget);
+
+    uint64_t hits() const { return hit_count; }
+    uint64_t misses() const { return miss_count; }
+
+    /*
+     * Returns the number of bytes of matcher tables in the cache
+     */
+    size_t memory_usage() const;
+
+    /*
+     * Returns the number of cached patterns
+     */
+    size_t size() const;
+};
+
+#endif
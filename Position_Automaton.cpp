@@ -0,0 +1,174 @@
+/*
+ * Position_Automaton implementation file
+ */
+
+#include <vector>
+#include <functional>
+
+#include "Position_Automaton.h"
+#include "Regex_AST.h"
+
+using namespace std;
+
+typedef Regex_Node::Type Type;
+
+// Implement std::hash<Position_Set>
+namespace std
+{
+  size_t hash<Position_Set>::operator()(const Position_Set& s) const
+  {
+    size_t ret {0};
+    for (auto w : s.words)
+    {
+      ret = ret * 31 + std::hash<uint64_t>()(w);
+    }
+
+    return ret;
+  }
+}
+
+bool Position_Set::empty() const
+{
+  for (auto w : words)
+  {
+    if (w != 0)
+      return false;
+  }
+
+  return true;
+}
+
+void Position_Set::clear()
+{
+  for (auto& w : words)
+  {
+    w = 0;
+  }
+}
+
+Position_Set& Position_Set::operator|=(const Position_Set& other)
+{
+  for (size_t i {0}; i < words.size(); i++)
+  {
+    words[i] |= other.words[i];
+  }
+
+  return *this;
+}
+
+bool Position_Set::intersects(const Position_Set& other) const
+{
+  for (size_t i {0}; i < words.size(); i++)
+  {
+    if (words[i] & other.words[i])
+      return true;
+  }
+
+  return false;
+}
+
+/*
+ * Returns the number of character leaves in a tree
+ */
+static size_t count_positions(const Regex_Node& node)
+{
+  size_t ret {node.type == Type::CHARACTER ? size_t {1} : 0};
+  for (auto& child : node.children)
+  {
+    ret += count_positions(*child);
+  }
+
+  return ret;
+}
+
+Position_Automaton::Position_Automaton(const Regex_Node& tree)
+{
+  size_t positions {count_positions(tree) + 1};
+  follow.assign(positions, Position_Set(positions));
+  position_chars.reserve(positions);
+
+  Position_Set last(positions);
+  first = Position_Set(positions);
+  bool nullable {compute(tree, first, last)};
+
+  // Augment the regex with the end marker: (tree)#
+  end_marker = position_chars.size();
+  position_chars.push_back({});
+
+  last.for_each([this](size_t p) { follow[p].set(end_marker); });
+  if (nullable)
+  {
+    first.set(end_marker);
+  }
+}
+
+bool Position_Automaton::compute(const Regex_Node& node,
+    Position_Set& first_pos, Position_Set& last_pos)
+{
+  size_t positions {follow.size()};
+
+  switch (node.type)
+  {
+    case Type::EMPTY:
+      return true;
+
+    case Type::CHARACTER:
+      first_pos.set(position_chars.size());
+      last_pos.set(position_chars.size());
+      position_chars.push_back(node.chars);
+      return false;
+
+    case Type::GROUP:
+      return compute(*node.children.front(), first_pos, last_pos);
+
+    case Type::CLOSURE:
+    {
+      compute(*node.children.front(), first_pos, last_pos);
+
+      // Every last position can be followed by every first position
+      last_pos.for_each([&](size_t p) { follow[p] |= first_pos; });
+      return true;
+    }
+
+    case Type::ALTERNATION:
+    {
+      bool nullable {false};
+      for (auto& child : node.children)
+      {
+        Position_Set child_first(positions);
+        Position_Set child_last(positions);
+        nullable |= compute(*child, child_first, child_last);
+
+        first_pos |= child_first;
+        last_pos |= child_last;
+      }
+      return nullable;
+    }
+
+    case Type::CONCATENATION:
+    {
+      // Fold the children left to right
+      bool nullable {true};
+      for (auto& child : node.children)
+      {
+        Position_Set child_first(positions);
+        Position_Set child_last(positions);
+        bool child_nullable {compute(*child, child_first, child_last)};
+
+        last_pos.for_each([&](size_t p) { follow[p] |= child_first; });
+
+        if (nullable)
+          first_pos |= child_first;
+
+        if (!child_nullable)
+          last_pos.clear();
+
+        last_pos |= child_last;
+        nullable &= child_nullable;
+      }
+      return nullable;
+    }
+  }
+
+  return false;
+}
@@ -0,0 +1,162 @@
+#ifndef POSITION_AUTOMATON_H
+#define POSITION_AUTOMATON_H
+
+#include <cstdint>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+#include "Char_Set.h"
+#include "Regex_AST.h"
+
+class Position_Set;
+
+// declare std::hash<Position_Set>
+namespace std
+{
+  template<>
+  struct hash<Position_Set>
+  {
+    public:
+      size_t operator()(const Position_Set& s) const;
+  };
+}
+
+/*
+ * A set of regex positions stored as a bitset.
+ * Sets held in std::pmr containers allocate from the container's memory
+ * resource.
+ */
+class Position_Set
+{
+  private:
+    std::pmr::vector<uint64_t> words;
+
+  public:
+
+    typedef std::pmr::polymorphic_allocator<uint64_t> allocator_type;
+
+    /*
+     * Constructs an empty set able to hold positions [0, size)
+     */
+    Position_Set(size_t size = 0, const allocator_type& allocator = {}) :
+      words((size + 63) / 64, allocator) {}
+
+    Position_Set(const Position_Set& other) = default;
+    Position_Set(Position_Set&& other) = default;
+
+    Position_Set(const Position_Set& other, const allocator_type& allocator) :
+      words(other.words, allocator) {}
+
+    Position_Set(Position_Set&& other, const allocator_type& allocator) :
+      words(std::move(other.words), allocator) {}
+
+    Position_Set& operator=(const Position_Set& other) = default;
+    Position_Set& operator=(Position_Set&& other) = default;
+
+    void set(size_t position)
+    {
+      words[position / 64] |= uint64_t {1} << (position % 64);
+    }
+
+    bool test(size_t position) const
+    {
+      return (words[position / 64] >> (position % 64)) & 1;
+    }
+
+    bool empty() const;
+
+    void clear();
+
+    /*
+     * Set union
+     */
+    Position_Set& operator|=(const Position_Set& other);
+
+    /*
+     * Returns true iff the sets have a common element
+     */
+    bool intersects(const Position_Set& other) const;
+
+    /*
+     * Calls visit(position) for every position in the set, in order
+     */
+    template <typename F>
+    void for_each(F visit) const
+    {
+      for (size_t i {0}; i < words.size(); i++)
+      {
+        for (uint64_t w {words[i]}; w != 0; w &= w - 1)
+        {
+          visit(i * 64 + __builtin_ctzll(w));
+        }
+      }
+    }
+
+    bool operator==(const Position_Set& other) const
+    {
+      return words == other.words;
+    }
+
+    bool operator!=(const Position_Set& other) const
+    {
+      return words != other.words;
+    }
+
+    // Give the hash function access to private members
+    friend size_t std::hash<Position_Set>::operator()(
+        const Position_Set& s) const;
+};
+
+/*
+ * A class representing the position (Glushkov) automaton of a regex.
+ * Every character leaf of the syntax tree is a position. The regex is
+ * augmented with an end marker position that matches no character, so
+ * a set of positions is accepting iff it contains the end marker.
+ *
+ * The automaton is described by the firstpos set of the augmented regex
+ * and the followpos set of every position.
+ */
+class Position_Automaton
+{
+  private:
+
+    // The characters matched at each position
+    std::vector<Char_Set> position_chars;
+
+    // followpos of each position
+    std::vector<Position_Set> follow;
+
+    // firstpos of the augmented regex
+    Position_Set first;
+
+    // The end marker's position
+    size_t end_marker;
+
+    /*
+     * Computes nullable, firstpos and lastpos of a subtree,
+     * recording followpos and the positions' characters as it goes.
+     * first_pos and last_pos must be empty.
+     */
+    bool compute(const Regex_Node& node, Position_Set& first_pos,
+        Position_Set& last_pos);
+
+  public:
+
+    /*
+     * Builds the position automaton of a syntax tree
+     */
+    Position_Automaton(const Regex_Node& tree);
+
+    /*
+     * Returns the number of positions, including the end marker
+     */
+    size_t size() const { return position_chars.size(); }
+
+    const Position_Set& get_first() const { return first; }
+    const Position_Set& get_follow(size_t p) const { return follow[p]; }
+    const Char_Set& get_chars(size_t p) const { return position_chars[p]; }
+    size_t get_end_marker() const { return end_marker; }
+};
+
+#endif
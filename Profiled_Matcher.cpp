@@ -0,0 +1,262 @@
+/*
+ * Profiled_Matcher implementation file
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "DFA_Matcher.h"
+#include "Profiled_Matcher.h"
+
+using namespace std;
+
+static const char ALPHABET_START {' '};
+static const char ALPHABET_END {'~'};
+
+#ifdef REGEX_PROFILE
+
+const bool Profiled_Matcher::ENABLED {true};
+
+/*
+ * Counters are only written by their thread, so a relaxed load and store
+ * is enough; they are atomic only so that reading them while the thread
+ * counts is not a data race.
+ */
+class Profiled_Matcher::Counters
+{
+  public:
+    vector<atomic<uint64_t>> visits;
+    vector<atomic<uint64_t>> transitions;
+
+    Counters(size_t states, size_t classes) :
+      visits(states), transitions(states * classes) {}
+
+    static void bump(atomic<uint64_t>& counter)
+    {
+      counter.store(counter.load(memory_order_relaxed) + 1,
+          memory_order_relaxed);
+    }
+};
+
+// Ids of the live and past matchers, never reused
+static atomic<uint64_t> next_id {0};
+
+Profiled_Matcher::Profiled_Matcher(const DFA_Matcher& m) :
+  matcher(m), id(next_id.fetch_add(1))
+{
+}
+
+Profiled_Matcher::Counters& Profiled_Matcher::local_counters() const
+{
+  /*
+   * The thread's counters for each matcher, used through the plain
+   * pointer while the matcher lives. The weak pointer tells when it is
+   * gone.
+   */
+  class Entry
+  {
+    public:
+      Counters* counters;
+      weak_ptr<Counters> owner;
+  };
+
+  thread_local unordered_map<uint64_t, Entry> local;
+
+  // Size of the cache that triggers dropping the destroyed matchers
+  thread_local size_t sweep_size {16};
+
+  auto it {local.find(id)};
+  if (it != local.end())
+  {
+    return *it->second.counters;
+  }
+
+  if (local.size() >= sweep_size)
+  {
+    erase_if(local, [](auto& entry) { return entry.second.owner.expired(); });
+    sweep_size = max<size_t>(16, 2 * local.size());
+  }
+
+  auto added {make_shared<Counters>(matcher.size(),
+      matcher.get_class_count())};
+
+  lock_guard<mutex> guard {lock};
+  counters.push_back(added);
+  local.emplace(id, Entry {added.get(), added});
+  return *added;
+}
+
+bool Profiled_Matcher::accept(string_view input) const
+{
+  auto& local {local_counters()};
+  unsigned classes {matcher.get_class_count()};
+
+  return matcher.with_rows([&](auto rows)
+  {
+    uint32_t state {matcher.get_start_state()};
+    Counters::bump(local.visits[state]);
+
+    for (unsigned char c : input)
+    {
+      Counters::bump(local.transitions[state * classes +
+          matcher.get_byte_class(c)]);
+
+      state = rows.delta(state, c);
+      Counters::bump(local.visits[state]);
+      if (state == DFA_Matcher::DEAD)
+      {
+        return false;
+      }
+    }
+
+    return matcher.is_accepting(state);
+  });
+}
+
+bool Profiled_Matcher::search(string_view input) const
+{
+  auto& local {local_counters()};
+  unsigned classes {matcher.get_class_count()};
+
+  return matcher.with_rows([&](auto rows)
+  {
+    // Try each starting position, stopping at the first accepting state
+    for (size_t begin {0}; begin <= input.size(); begin++)
+    {
+      uint32_t state {matcher.get_start_state()};
+      Counters::bump(local.visits[state]);
+      if (matcher.is_accepting(state))
+      {
+        return true;
+      }
+
+      for (size_t i {begin}; i < input.size(); i++)
+      {
+        unsigned char c = input[i];
+        Counters::bump(local.transitions[state * classes +
+            matcher.get_byte_class(c)]);
+
+        state = rows.delta(state, c);
+        Counters::bump(local.visits[state]);
+        if (state == DFA_Matcher::DEAD)
+          break;
+
+        if (matcher.is_accepting(state))
+          return true;
+      }
+    }
+
+    return false;
+  });
+}
+
+vector<uint64_t> Profiled_Matcher::visits() const
+{
+  vector<uint64_t> ret(matcher.size());
+
+  lock_guard<mutex> guard {lock};
+  for (auto& c : counters)
+  {
+    for (size_t s {0}; s < ret.size(); s++)
+    {
+      ret[s] += c->visits[s].load(memory_order_relaxed);
+    }
+  }
+
+  return ret;
+}
+
+vector<uint64_t> Profiled_Matcher::transitions() const
+{
+  vector<uint64_t> ret(matcher.size() * matcher.get_class_count());
+
+  lock_guard<mutex> guard {lock};
+  for (auto& c : counters)
+  {
+    for (size_t t {0}; t < ret.size(); t++)
+    {
+      ret[t] += c->transitions[t].load(memory_order_relaxed);
+    }
+  }
+
+  return ret;
+}
+
+#else
+
+const bool Profiled_Matcher::ENABLED {false};
+
+Profiled_Matcher::Profiled_Matcher(const DFA_Matcher& m) : matcher(m)
+{
+}
+
+bool Profiled_Matcher::accept(string_view input) const
+{
+  return matcher.accept(input);
+}
+
+bool Profiled_Matcher::search(string_view input) const
+{
+  return matcher.search(input);
+}
+
+vector<uint64_t> Profiled_Matcher::visits() const
+{
+  return vector<uint64_t>(matcher.size());
+}
+
+vector<uint64_t> Profiled_Matcher::transitions() const
+{
+  return vector<uint64_t>(matcher.size() * matcher.get_class_count());
+}
+
+#endif
+
+Profiled_Matcher::~Profiled_Matcher()
+{
+}
+
+void Profiled_Matcher::print(ostream& out) const
+{
+  unsigned classes {matcher.get_class_count()};
+  auto state_visits {visits()};
+  auto taken {transitions()};
+
+  // The characters of each class
+  vector<string> chars(classes);
+  for (char c {ALPHABET_START}; c <= ALPHABET_END; c++)
+  {
+    chars[matcher.get_byte_class(c)] += c;
+  }
+
+  for (uint32_t s {1}; s < matcher.size(); s++)
+  {
+    out << "STATE " << s << ": ";
+    for (unsigned cls {0}; cls < classes; cls++)
+    {
+      auto dst {matcher.delta(s, chars[cls].empty() ? 0 : chars[cls][0])};
+      if (dst != DFA_Matcher::DEAD)
+      {
+        out << '(' << chars[cls] << ", " << dst << ", "
+          << taken[s * classes + cls] << ") ";
+      }
+    }
+    out << endl;
+
+    if (s == matcher.get_start_state())
+      out << "START STATE" << endl;
+
+    if (matcher.is_accepting(s))
+      out << "ACCEPTING STATE " << endl;
+
+    out << "VISITS " << state_visits[s] << endl << endl;
+  }
+
+  out << "DEAD STATE VISITS " << state_visits[DFA_Matcher::DEAD] << endl;
+}
@@ -0,0 +1,89 @@
+#ifndef PROFILED_MATCHER_H
+#define PROFILED_MATCHER_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include "DFA_Matcher.h"
+
+/*
+ * A matcher that records where a workload spends its time: how many times
+ * each state is visited and each transition taken by accept() and
+ * search(). Each thread counts into its own counters, which are summed
+ * when read, so profiling a shared matcher needs no synchronization.
+ * A thread finds its counters in a cache keyed by matcher, whose entries
+ * for destroyed matchers are dropped as the cache grows.
+ *
+ * Profiling is compiled in only with REGEX_PROFILE defined. Otherwise
+ * the calls go straight to the DFA_Matcher and every count is 0.
+ */
+class Profiled_Matcher
+{
+  private:
+
+    const DFA_Matcher& matcher;
+
+#ifdef REGEX_PROFILE
+    // The counters of one thread
+    class Counters;
+
+    // Identifies the matcher's counters in each thread
+    uint64_t id;
+
+    mutable std::mutex lock;
+    mutable std::vector<std::shared_ptr<Counters>> counters;
+
+    /*
+     * Returns the calling thread's counters, adding them on first use
+     */
+    Counters& local_counters() const;
+#endif
+
+  public:
+
+    /*
+     * True iff profiling is compiled in
+     */
+    static const bool ENABLED;
+
+    /*
+     * Profiles a matcher, which must outlive the Profiled_Matcher
+     */
+    Profiled_Matcher(const DFA_Matcher& matcher);
+    ~Profiled_Matcher();
+
+    /*
+     * Same as DFA_Matcher::accept
+     */
+    bool accept(std::string_view input) const;
+
+    /*
+     * Same as DFA_Matcher::search
+     */
+    bool search(std::string_view input) const;
+
+    /*
+     * Returns the number of visits of each state, which can be passed to
+     * DFA_Matcher::layout
+     */
+    std::vector<uint64_t> visits() const;
+
+    /*
+     * Returns the number of times each transition was taken, indexed by
+     * state * class count + class
+     */
+    std::vector<uint64_t> transitions() const;
+
+    /*
+     * Prints the states with their visits, and their transitions with the
+     * characters of their class and the times they were taken, in the
+     * style of DFA::print
+     */
+    void print(std::ostream& out) const;
+};
+
+#endif
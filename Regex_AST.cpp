@@ -0,0 +1,300 @@
+/*
+ * Regex_AST implementation file
+ */
+
+#include <string>
+#include <memory>
+#include <algorithm>
+
+#include "Regex_AST.h"
+#include "NFA.h"
+
+using namespace std;
+
+static const char ALPHABET_BEGIN {' '};
+static const char ALPHABET_END {'~'};
+
+Regex_Node::Regex_Node(Type t, unique_ptr<Regex_Node> op1,
+    unique_ptr<Regex_Node> op2) : type(t)
+{
+  children.push_back(std::move(op1));
+  if (op2 != nullptr)
+  {
+    children.push_back(std::move(op2));
+  }
+}
+
+unique_ptr<Regex_Node> Regex_Node::clone() const
+{
+  auto ret {std::make_unique<Regex_Node>(type)};
+  ret->chars = chars;
+  ret->group = group;
+  for (auto& child : children)
+  {
+    ret->children.push_back(child->clone());
+  }
+
+  return ret;
+}
+
+bool Regex_Node::operator==(const Regex_Node& other) const
+{
+  if (type != other.type || chars != other.chars || group != other.group ||
+      children.size() != other.children.size())
+  {
+    return false;
+  }
+
+  for (size_t i {0}; i < children.size(); i++)
+  {
+    if (*children[i] != *other.children[i])
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool Regex_Node::nullable() const
+{
+  switch (type)
+  {
+    case Type::EMPTY:
+    case Type::CLOSURE:
+      return true;
+
+    case Type::CHARACTER:
+      return false;
+
+    case Type::GROUP:
+      return children.front()->nullable();
+
+    case Type::CONCATENATION:
+      for (auto& child : children)
+      {
+        if (!child->nullable())
+          return false;
+      }
+      return true;
+
+    case Type::ALTERNATION:
+      for (auto& child : children)
+      {
+        if (child->nullable())
+          return true;
+      }
+      return false;
+  }
+
+  return false;
+}
+
+size_t Regex_Node::size() const
+{
+  size_t ret {1};
+  for (auto& child : children)
+  {
+    ret += child->size();
+  }
+
+  return ret;
+}
+
+unsigned Regex_Node::group_count() const
+{
+  unsigned ret {group};
+  for (auto& child : children)
+  {
+    ret = std::max(ret, child->group_count());
+  }
+
+  return ret;
+}
+
+void Regex_Node::fold_case()
+{
+  if (type == Type::CHARACTER)
+  {
+    for (char c {'a'}; c <= 'z'; c++)
+    {
+      char upper = c - 'a' + 'A';
+      if (chars.test(c) || chars.test(upper))
+      {
+        chars.set(c);
+        chars.set(upper);
+      }
+    }
+  }
+
+  for (auto& child : children)
+  {
+    child->fold_case();
+  }
+}
+
+unique_ptr<NFA> Regex_Node::to_nfa() const
+{
+  switch (type)
+  {
+    case Type::GROUP:
+      return children.front()->to_nfa();
+
+    case Type::EMPTY:
+      return std::make_unique<NFA>(NFA::EPSILON);
+
+    case Type::CHARACTER:
+      return std::make_unique<NFA>(chars);
+
+    case Type::CLOSURE:
+    {
+      auto nfa {children.front()->to_nfa()};
+      nfa->closure();
+      return nfa;
+    }
+
+    case Type::CONCATENATION:
+    case Type::ALTERNATION:
+    {
+      auto nfa {children.front()->to_nfa()};
+      for (size_t i {1}; i < children.size(); i++)
+      {
+        auto operand {children[i]->to_nfa()};
+        if (type == Type::CONCATENATION)
+        {
+          nfa->concatenate(operand);
+        }
+        else
+        {
+          nfa->disjunction(operand);
+        }
+      }
+      return nfa;
+    }
+  }
+
+  return nullptr;
+}
+
+/*
+ * Writes a single character, escaping metacharacters
+ */
+static string char_to_string(char c)
+{
+  switch (c)
+  {
+    case ' ':
+      return "\\s";
+
+    case '(': case ')': case '[': case ']': case '*': case '|': case '\\':
+      return string("\\") + c;
+
+    default:
+      return string(1, c);
+  }
+}
+
+/*
+ * Writes a character set as a single character or a bracket expression
+ */
+static string set_to_string(const Char_Set& set)
+{
+  if (set.count() == 1)
+  {
+    for (char c {ALPHABET_BEGIN}; c <= ALPHABET_END; c++)
+    {
+      if (set.test(c))
+        return char_to_string(c);
+    }
+  }
+
+  // Blanks are removed from the regex, so they cannot appear in a bracket
+  if (set.test(' '))
+  {
+    auto rest {set};
+    rest.reset(' ');
+    return rest.none() ? "\\s" : "(\\s|" + set_to_string(rest) + ")";
+  }
+
+  // A leading '^' would complement the bracket expression
+  auto rest {set};
+  rest.reset('^');
+  rest.reset('-');
+  if (set.test('^') && (rest << (128 - '^')).none())
+  {
+    rest.set('-', set.test('-'));
+    return "(^|" + set_to_string(rest) + ")";
+  }
+
+  // ']' must come first and '-' must come last
+  string ret {set.test(']') ? "]" : ""};
+  for (char c {'!'}; c <= ALPHABET_END; c++)
+  {
+    if (!set.test(c) || c == ']' || c == '-')
+      continue;
+
+    char end {c};
+    while (end < ALPHABET_END && set.test(end + 1) && end + 1 != ']' &&
+        end + 1 != '-')
+    {
+      end++;
+    }
+
+    if (end - c > 1)
+      ret += string{c, '-', end};
+    else if (end != c)
+      ret += string{c, end};
+    else
+      ret += c;
+
+    c = end;
+  }
+
+  if (set.test('-'))
+    ret += '-';
+
+  return "[" + ret + "]";
+}
+
+string Regex_Node::to_string() const
+{
+  string ret;
+  switch (type)
+  {
+    case Type::EMPTY:
+      return "()";
+
+    case Type::CHARACTER:
+      return set_to_string(chars);
+
+    case Type::GROUP:
+      return "(" + children.front()->to_string() + ")";
+
+    case Type::CLOSURE:
+      ret = children.front()->to_string();
+      if (children.front()->type == Type::CONCATENATION ||
+          children.front()->type == Type::CLOSURE)
+      {
+        ret = "(" + ret + ")";
+      }
+      return ret + "*";
+
+    case Type::CONCATENATION:
+      for (auto& child : children)
+      {
+        ret += child->to_string();
+      }
+      return ret;
+
+    case Type::ALTERNATION:
+      for (auto& child : children)
+      {
+        if (!ret.empty())
+          ret += "|";
+        ret += child->to_string();
+      }
+      return "(" + ret + ")";
+  }
+
+  return ret;
+}
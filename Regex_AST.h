@@ -0,0 +1,106 @@
+#ifndef REGEX_AST_H
+#define REGEX_AST_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Char_Set.h"
+#include "NFA.h"
+
+/*
+ * A class representing a node in a regular expression's abstract syntax tree.
+ * Concatenation and alternation nodes may have any number of children,
+ * closure and group nodes have exactly one and the leaves have none.
+ */
+class Regex_Node
+{
+  public:
+    enum class Type
+    {
+      EMPTY,          // matches only the empty string
+      CHARACTER,      // matches one character from a set
+      CONCATENATION,
+      ALTERNATION,
+      CLOSURE,
+      GROUP           // a parenthesized capture group
+    };
+
+    Type type;
+
+    // The characters matched by a CHARACTER node
+    Char_Set chars;
+
+    // The capture group number of a GROUP node, starting at 1
+    unsigned group {0};
+
+    std::vector<std::unique_ptr<Regex_Node>> children;
+
+    /*
+     * Constructs a node with no children
+     */
+    Regex_Node(Type t) : type(t) {}
+
+    /*
+     * Constructs a CHARACTER node matching any character in set
+     */
+    Regex_Node(const Char_Set& set) : type(Type::CHARACTER), chars(set) {}
+
+    /*
+     * Constructs a CHARACTER node matching the single character c
+     */
+    Regex_Node(char c) : type(Type::CHARACTER) { chars.set(c); }
+
+    /*
+     * Constructs a node of type t with the given operands
+     */
+    Regex_Node(Type t, std::unique_ptr<Regex_Node> op1,
+        std::unique_ptr<Regex_Node> op2 = nullptr);
+
+    /*
+     * Returns a deep copy of the tree rooted at this node
+     */
+    std::unique_ptr<Regex_Node> clone() const;
+
+    /*
+     * Structural equality of two trees
+     */
+    bool operator==(const Regex_Node& other) const;
+    bool operator!=(const Regex_Node& other) const { return !(*this == other); }
+
+    /*
+     * Returns true iff the tree matches the empty string
+     */
+    bool nullable() const;
+
+    /*
+     * Returns the number of nodes in the tree
+     */
+    size_t size() const;
+
+    /*
+     * Returns the highest capture group number in the tree
+     */
+    unsigned group_count() const;
+
+    /*
+     * Makes the tree case insensitive: every CHARACTER node matching a
+     * letter also matches the letter's other case. The tree keeps its
+     * shape, but its DFA can have more states: a widened set may overlap
+     * sets it was disjoint from.
+     */
+    void fold_case();
+
+    /*
+     * Builds an NFA for the tree using Thompson's construction
+     */
+    std::unique_ptr<NFA> to_nfa() const;
+
+    /*
+     * Returns a description of the tree in regex syntax.
+     * The empty string is written as "()".
+     */
+    std::string to_string() const;
+};
+
+#endif
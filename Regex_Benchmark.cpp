@@ -0,0 +1,123 @@
+/*
+ * Compares the costs of the regex compilation paths
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "Comb_Matcher.h"
+#include "DFA.h"
+#include "DFA_Matcher.h"
+#include "NFA.h"
+#include "Regex_AST.h"
+#include "Regex_Optimizer.h"
+#include "Regex_Parser.h"
+#include "Position_Automaton.h"
+
+using namespace std;
+
+static const int ITERATIONS {20};
+
+// Patterns dominated by closures and alternation
+static const vector<string> DEFAULT_PATTERNS {
+  "(a|b)*abb",
+  "(a|b)*a(a|b)(a|b)(a|b)(a|b)(a|b)",
+  "([a-z]|[A-Z]|_)([a-z]|[A-Z]|[0-9]|_)*",
+  "(ab|cd|ef|gh)*(ij|kl)*(mn|op)",
+  "if|else|while|for|return|break|continue|switch|case|default",
+  "((a|b)*c(d|e)*)*f",
+  "[0-9][0-9]*(.[0-9][0-9]*)*(e(+|-)[0-9][0-9]*)*"
+};
+
+/*
+ * Returns the mean number of microseconds taken by compile()
+ */
+template <typename F>
+double time_us(F compile)
+{
+  auto begin {chrono::steady_clock::now()};
+  for (int i {0}; i < ITERATIONS; i++)
+  {
+    compile();
+  }
+
+  chrono::duration<double, micro> elapsed {chrono::steady_clock::now() - begin};
+  return elapsed.count() / ITERATIONS;
+}
+
+int main(int argc, char* argv[])
+{
+  vector<string> patterns(argv + 1, argv + argc);
+  if (patterns.empty())
+  {
+    patterns = DEFAULT_PATTERNS;
+  }
+
+  /*
+   * Thompson columns, then followpos columns, then minimization.
+   * Construction times do not include minimization, which is the same
+   * for both paths. Then the sizes of the dense and comb vector tables.
+   */
+  cout << setw(8) << "nfa" << setw(8) << "dfa" << setw(12) << "us"
+    << setw(11) << "positions" << setw(8) << "dfa" << setw(12) << "us"
+    << setw(8) << "min" << setw(12) << "us"
+    << setw(9) << "table" << setw(9) << "comb" << "  pattern" << endl;
+
+  for (auto& pattern : patterns)
+  {
+    size_t nfa_states {0}, thompson_states {0}, positions {0},
+      followpos_states {0}, minimized_states {0};
+    unique_ptr<DFA> dfa;
+
+    try
+    {
+      // Thompson's construction -> subset construction
+      double thompson_us {time_us([&]()
+      {
+        auto nfa {Regex_Parser::regex_to_nfa(pattern)};
+        DFA dfa {*nfa};
+        nfa_states = nfa->size();
+        thompson_states = dfa.size();
+      })};
+
+      // followpos -> subset construction over positions
+      double followpos_us {time_us([&]()
+      {
+        auto tree {Regex_Optimizer::optimize(
+            Regex_Parser::regex_to_ast(pattern))};
+        Position_Automaton automaton {*tree};
+        dfa = std::make_unique<DFA>(automaton);
+        positions = automaton.size();
+        followpos_states = dfa->size();
+      })};
+
+      auto begin {chrono::steady_clock::now()};
+      dfa->minimize();
+      chrono::duration<double, micro> minimize_us {
+        chrono::steady_clock::now() - begin};
+      minimized_states = dfa->size();
+
+      DFA_Matcher matcher {*dfa};
+      Comb_Matcher comb {matcher};
+
+      cout << fixed << setprecision(1)
+        << setw(8) << nfa_states << setw(8) << thompson_states
+        << setw(12) << thompson_us
+        << setw(11) << positions << setw(8) << followpos_states
+        << setw(12) << followpos_us
+        << setw(8) << minimized_states << setw(12) << minimize_us.count()
+        << setw(9) << matcher.memory_usage() << setw(9) << comb.memory_usage()
+        << "  " << pattern << endl;
+    }
+    catch (std::runtime_error& e)
+    {
+      cerr << "Invalid Regex " << pattern << ": " << e.what() << endl;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,53 @@
+/*
+ * Generates a C++ header matching a regex ahead of time
+ *
+ * Usage: Regex_Codegen [--table | --direct] name regex
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "DFA_Codegen.h"
+#include "Regex_Compiler.h"
+
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+  auto mode {DFA_Codegen::Mode::TABLE};
+  int arg {1};
+
+  if (arg < argc && string(argv[arg]) == "--table")
+  {
+    arg++;
+  }
+  else if (arg < argc && string(argv[arg]) == "--direct")
+  {
+    mode = DFA_Codegen::Mode::DIRECT;
+    arg++;
+  }
+
+  if (argc - arg != 2)
+  {
+    cerr << "Usage: " << argv[0] << " [--table | --direct] name regex"
+      << endl;
+    return 1;
+  }
+
+  string name {argv[arg]};
+  string pattern {argv[arg + 1]};
+
+  try
+  {
+    auto matcher {Regex_Compiler::compile(pattern)};
+    DFA_Codegen::generate(cout, *matcher, name, pattern, mode);
+  }
+  catch (std::runtime_error& e)
+  {
+    cerr << "Invalid Regex " << pattern << ": " << e.what() << endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,48 @@
+/*
+ * Regex_Compiler implementation file
+ */
+
+#include <memory>
+#include <string>
+
+#include "DFA.h"
+#include "DFA_Matcher.h"
+#include "Position_Automaton.h"
+#include "Regex_Compiler.h"
+#include "Regex_Optimizer.h"
+#include "Regex_Parser.h"
+
+using namespace std;
+
+unique_ptr<DFA> Regex_Compiler::compile_dfa(const string& regex,
+    const Compile_Limits& limits, bool case_fold)
+{
+  // Fold before optimizing, so a|A merges into one character
+  auto tree {Regex_Parser::regex_to_ast(regex)};
+  if (case_fold)
+  {
+    tree->fold_case();
+  }
+
+  tree = Regex_Optimizer::optimize(std::move(tree));
+  return compile_dfa(*tree, limits);
+}
+
+unique_ptr<DFA> Regex_Compiler::compile_dfa(const Regex_Node& tree,
+    const Compile_Limits& limits)
+{
+  Compile_Budget budget {limits};
+
+  Position_Automaton automaton {tree};
+  auto dfa {std::make_unique<DFA>(automaton, &budget)};
+  dfa->minimize(&budget);
+
+  return dfa;
+}
+
+unique_ptr<DFA_Matcher> Regex_Compiler::compile(const string& regex,
+    const Compile_Limits& limits, bool case_fold)
+{
+  return std::make_unique<DFA_Matcher>(*compile_dfa(regex, limits,
+        case_fold));
+}
@@ -0,0 +1,58 @@
+#ifndef REGEX_COMPILER_H
+#define REGEX_COMPILER_H
+
+#include <memory>
+#include <string>
+
+#include "Compile_Limits.h"
+#include "DFA.h"
+#include "DFA_Matcher.h"
+#include "Regex_AST.h"
+
+/*
+ * A class that runs the whole regex compilation pipeline:
+ * parse -> optimize -> position automaton -> DFA -> minimize -> tables
+ */
+class Regex_Compiler
+{
+  private:
+
+    /*
+     * Private constructor
+     */
+    Regex_Compiler() {}
+
+  public:
+
+    /*
+     * Compiles a regex into a minimal DFA, for combining with others
+     * (see DFA::product) before building a matcher. With case_fold,
+     * letters match either case.
+     * Throws std::runtime_error if the regex is invalid, and
+     * Compile_Limit_Error if the DFA goes over the limits.
+     */
+    static std::unique_ptr<DFA> compile_dfa(const std::string& regex,
+        const Compile_Limits& limits = Compile_Limits(),
+        bool case_fold = false);
+
+    /*
+     * Compiles an optimized syntax tree into a minimal DFA.
+     * Throws Compile_Limit_Error if the DFA goes over the limits.
+     */
+    static std::unique_ptr<DFA> compile_dfa(const Regex_Node& tree,
+        const Compile_Limits& limits = Compile_Limits());
+
+    /*
+     * Compiles a regex into a table matcher. With case_fold, letters
+     * match either case. Both cases share a byte class, so matching costs
+     * the same, but the DFA can have more states (see
+     * Regex_Node::fold_case).
+     * Throws std::runtime_error if the regex is invalid, and
+     * Compile_Limit_Error if the DFA goes over the limits.
+     */
+    static std::unique_ptr<DFA_Matcher> compile(const std::string& regex,
+        const Compile_Limits& limits = Compile_Limits(),
+        bool case_fold = false);
+};
+
+#endif
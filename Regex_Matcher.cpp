@@ -2,16 +2,326 @@
  * A regular expression matching program
  */
 
+#include <algorithm>
+#include <charconv>
 #include <iostream>
 #include <exception>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
 
+#include "Approximate_Matcher.h"
 #include "DFA.h"
+#include "DFA_Matcher.h"
+#include "File_Scanner.h"
+#include "Match_Server.h"
 #include "NFA.h"
+#include "Pattern_Cache.h"
+#include "Profiled_Matcher.h"
+#include "Regex_Compiler.h"
 #include "Regex_Parser.h"
+#include "Rule_Analyzer.h"
 
 using namespace std;
 
-int main()
+// Bytes of compiled matcher tables kept for reuse
+static const size_t CACHE_BUDGET {64 << 20};
+
+// Patterns with larger DFAs are matched with the NFA instead
+static const size_t MAX_DFA_STATES {100000};
+static const size_t MAX_TABLE_BYTES {64 << 20};
+static const chrono::seconds MAX_COMPILE_TIME {5};
+
+// Patterns used this many times are compiled to native code
+static const uint64_t JIT_THRESHOLD {1000};
+
+/*
+ * Parses a count argument, such as a number of threads, into count.
+ * Returns false if it is not a number that fits.
+ */
+static bool parse_count(const string& text, unsigned& count)
+{
+  auto end {text.data() + text.size()};
+  auto [last, error] {from_chars(text.data(), end, count)};
+  return error == errc() && last == end;
+}
+
+/*
+ * Scan mode: Regex_Matcher --scan [-i] [-j threads] regex path...
+ * Prints the lines of the files under the paths that contain a match,
+ * ignoring case with -i.
+ * Returns 0 if some line matched, 1 if none did, and 2 on errors.
+ */
+static int scan(const vector<string>& args, const Compile_Limits& limits)
+{
+  static const char USAGE[]
+    {"Usage: Regex_Matcher --scan [-i] [-j threads] regex path..."};
+
+  unsigned threads {0};
+  bool case_fold {false};
+  size_t arg {0};
+  for (;; arg++)
+  {
+    if (arg + 1 < args.size() && args[arg] == "-j")
+    {
+      if (!parse_count(args[++arg], threads))
+      {
+        cerr << USAGE << endl;
+        return 2;
+      }
+    }
+    else if (arg < args.size() && args[arg] == "-i")
+    {
+      case_fold = true;
+    }
+    else
+    {
+      break;
+    }
+  }
+
+  if (args.size() - arg < 2)
+  {
+    cerr << USAGE << endl;
+    return 2;
+  }
+
+  unique_ptr<DFA_Matcher> matcher;
+  try
+  {
+    matcher = Regex_Compiler::compile(args[arg], limits, case_fold);
+  }
+  catch (std::runtime_error& e)
+  {
+    cerr << "Invalid Regex: " << e.what() << endl;
+    return 2;
+  }
+
+  File_Scanner scanner {*matcher, threads};
+  vector<string> paths(args.begin() + arg + 1, args.end());
+  size_t matched {scanner.scan(paths, cout)};
+  if (scanner.error_count() > 0)
+  {
+    return 2;
+  }
+
+  return matched > 0 ? 0 : 1;
+}
+
+/*
+ * Check mode: Regex_Matcher --check-rules file
+ * Reports the rules, one regex per line of the file, that duplicate or
+ * are subsumed by another rule.
+ * Returns 0 if none are redundant, 1 if some are, and 2 on errors.
+ */
+static int check_rules(const vector<string>& args,
+    const Compile_Limits& limits)
+{
+  if (args.size() != 1)
+  {
+    cerr << "Usage: Regex_Matcher --check-rules file" << endl;
+    return 2;
+  }
+
+  ifstream file {args[0]};
+  if (!file)
+  {
+    cerr << "Cannot open " << args[0] << endl;
+    return 2;
+  }
+
+  vector<string> rules;
+  for (string line; getline(file, line);)
+  {
+    rules.push_back(line);
+  }
+
+  vector<Rule_Analyzer::Finding> findings;
+  try
+  {
+    findings = Rule_Analyzer::analyze(rules, limits);
+  }
+  catch (std::runtime_error& e)
+  {
+    cerr << "Invalid Regex: " << e.what() << endl;
+    return 2;
+  }
+
+  // Lines are numbered from 1
+  for (auto& f : findings)
+  {
+    cout << args[0] << ':' << f.rule + 1 << ": "
+      << (f.kind == Rule_Analyzer::Finding::Kind::DUPLICATE ?
+          "duplicate of line " : "subsumed by line ")
+      << f.by + 1 << ": " << rules[f.rule] << endl;
+  }
+
+  return findings.empty() ? 0 : 1;
+}
+
+/*
+ * Server mode: Regex_Matcher --serve [-j threads] socket file
+ * Compiles the patterns, one regex per line of the file, and serves
+ * batches of matches against them on a Unix domain socket (see
+ * Match_Server). Returns 2 on errors.
+ */
+static int serve(const vector<string>& args, const Compile_Limits& limits)
+{
+  static const char USAGE[]
+    {"Usage: Regex_Matcher --serve [-j threads] socket file"};
+
+  unsigned threads {0};
+  size_t arg {0};
+  if (arg + 1 < args.size() && args[arg] == "-j")
+  {
+    if (!parse_count(args[arg + 1], threads))
+    {
+      cerr << USAGE << endl;
+      return 2;
+    }
+
+    arg += 2;
+  }
+
+  if (args.size() - arg != 2)
+  {
+    cerr << USAGE << endl;
+    return 2;
+  }
+
+  ifstream file {args[arg + 1]};
+  if (!file)
+  {
+    cerr << "Cannot open " << args[arg + 1] << endl;
+    return 2;
+  }
+
+  vector<unique_ptr<DFA_Matcher>> matchers;
+  for (string line; getline(file, line);)
+  {
+    try
+    {
+      matchers.push_back(Regex_Compiler::compile(line, limits));
+      matchers.back()->set_jit_threshold(JIT_THRESHOLD);
+    }
+    catch (std::runtime_error& e)
+    {
+      cerr << "Invalid Regex on line " << matchers.size() + 1 << ": "
+        << e.what() << endl;
+      return 2;
+    }
+  }
+
+  try
+  {
+    Match_Server server {std::move(matchers), threads};
+    server.serve(args[arg]);
+  }
+  catch (std::runtime_error& e)
+  {
+    cerr << e.what() << endl;
+    return 2;
+  }
+
+  return 0;
+}
+
+/*
+ * Fuzzy mode: Regex_Matcher --fuzzy errors regex
+ * Prints the lines of standard input containing a substring within
+ * errors edits of the regex, each after the fewest edits it takes.
+ * Returns 0 if some line matched, 1 if none did, and 2 on errors.
+ */
+static int fuzzy(const vector<string>& args, const Compile_Limits& limits)
+{
+  // More errors than the regex has characters match anything
+  unsigned errors {0};
+  if (args.size() != 2 || !parse_count(args[0], errors) ||
+      errors > args[1].size())
+  {
+    cerr << "Usage: Regex_Matcher --fuzzy errors regex" << endl;
+    cerr << "errors is at most the length of the regex" << endl;
+    return 2;
+  }
+
+  unique_ptr<Approximate_Matcher> matcher;
+  try
+  {
+    matcher = std::make_unique<Approximate_Matcher>(args[1], errors, limits);
+  }
+  catch (Compile_Limit_Error& e)
+  {
+    cerr << "Regex too large: " << e.what() << endl;
+    return 2;
+  }
+  catch (std::runtime_error& e)
+  {
+    cerr << "Invalid Regex: " << e.what() << endl;
+    return 2;
+  }
+
+  bool matched {false};
+  for (string line; getline(cin, line);)
+  {
+    auto matches {matcher->search(line)};
+    if (matches.empty())
+      continue;
+
+    auto closest {min_element(matches.begin(), matches.end(),
+        [](auto& a, auto& b) { return a.distance < b.distance; })};
+    cout << closest->distance << ": " << line << endl;
+    matched = true;
+  }
+
+  return matched ? 0 : 1;
+}
+
+/*
+ * Profile mode: Regex_Matcher --profile regex
+ * Searches each line of standard input, then prints the matcher's states
+ * with their visits and the uses of their transitions. Needs a build
+ * with REGEX_PROFILE defined.
+ * Returns 0 if some line matched, 1 if none did, and 2 on errors.
+ */
+static int profile(const vector<string>& args, const Compile_Limits& limits)
+{
+  if (args.size() != 1)
+  {
+    cerr << "Usage: Regex_Matcher --profile regex" << endl;
+    return 2;
+  }
+
+  if (!Profiled_Matcher::ENABLED)
+  {
+    cerr << "Profiling is not compiled in: add -DREGEX_PROFILE to CXXFLAGS"
+      << endl;
+    return 2;
+  }
+
+  unique_ptr<DFA_Matcher> matcher;
+  try
+  {
+    matcher = Regex_Compiler::compile(args[0], limits);
+  }
+  catch (std::runtime_error& e)
+  {
+    cerr << "Invalid Regex: " << e.what() << endl;
+    return 2;
+  }
+
+  Profiled_Matcher profiled {*matcher};
+  bool matched {false};
+  for (string line; getline(cin, line);)
+  {
+    matched = profiled.search(line) || matched;
+  }
+
+  profiled.print(cout);
+  return matched ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
 {
   // Prints the program's title
   void print_title();
@@ -19,6 +329,36 @@ int main()
 //  print_title();
   
   string input_regex {""};
+  Compile_Limits limits;
+  limits.max_states = MAX_DFA_STATES;
+  limits.max_table_bytes = MAX_TABLE_BYTES;
+  limits.max_time = MAX_COMPILE_TIME;
+
+  if (argc > 1 && string(argv[1]) == "--scan")
+  {
+    return scan(vector<string>(argv + 2, argv + argc), limits);
+  }
+
+  if (argc > 1 && string(argv[1]) == "--serve")
+  {
+    return serve(vector<string>(argv + 2, argv + argc), limits);
+  }
+
+  if (argc > 1 && string(argv[1]) == "--check-rules")
+  {
+    return check_rules(vector<string>(argv + 2, argv + argc), limits);
+  }
+
+  if (argc > 1 && string(argv[1]) == "--fuzzy")
+  {
+    return fuzzy(vector<string>(argv + 2, argv + argc), limits);
+  }
+
+  if (argc > 1 && string(argv[1]) == "--profile")
+  {
+    return profile(vector<string>(argv + 2, argv + argc), limits);
+  }
+  Pattern_Cache cache {CACHE_BUDGET, limits, JIT_THRESHOLD};
  
   // Main program loop:
   // Accept regular expressions from user until they enter "quit"
@@ -27,10 +367,17 @@ int main()
     cout << "Enter a regular expression. Type \"quit\" to quit: ";
     getline(cin, input_regex);
 
-    // Parse the regular expression and create an NFA
+    // Compile the regular expression, reusing it if it was seen before
+    Pattern_Cache::Matcher_Ptr matcher;
     unique_ptr<NFA> nfa_pt;
     try
     {
+      matcher = cache.get(input_regex);
+    }
+    catch (Compile_Limit_Error& e)
+    {
+      // The DFA is too large. Fall back to simulating the NFA.
+      cerr << e.what() << ". Matching with the NFA." << endl;
       nfa_pt = Regex_Parser::regex_to_nfa(input_regex);
     }
     catch (std::runtime_error& e)
@@ -45,10 +392,6 @@ int main()
       break;
     }
 
-    // create minimized DFA
-    DFA dfa{*nfa_pt};
-    dfa.minimize();
-
     // Ask for strings for the DFA to accept
     string to_accept;
     cout << "Enter the strings to be accepted by \"" << input_regex;
@@ -57,7 +400,8 @@ int main()
     getline(cin, to_accept);
     while (to_accept != "quit")
     {
-      bool accepted {dfa.accept(to_accept)};
+      bool accepted {matcher != nullptr ? matcher->accept(to_accept) :
+        nfa_pt->accept(to_accept)};
 
       if (accepted)
       {
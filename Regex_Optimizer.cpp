@@ -0,0 +1,386 @@
+/*
+ * Regex_Optimizer implementation file
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "Regex_AST.h"
+#include "Regex_Optimizer.h"
+
+using namespace std;
+
+typedef Regex_Node::Type Type;
+
+/*
+ * Returns the lowest character in a set
+ */
+static char first_char(const Char_Set& set)
+{
+  char c {0};
+  while (!set.test(c))
+    c++;
+
+  return c;
+}
+
+unique_ptr<Regex_Node> Regex_Optimizer::optimize(unique_ptr<Regex_Node> tree,
+    bool keep_groups)
+{
+  if (!keep_groups)
+  {
+    strip_groups(tree);
+  }
+
+  simplify(tree);
+  return tree;
+}
+
+void Regex_Optimizer::strip_groups(unique_ptr<Regex_Node>& node)
+{
+  while (node->type == Type::GROUP)
+  {
+    auto child {std::move(node->children.front())};
+    node = std::move(child);
+  }
+
+  for (auto& child : node->children)
+  {
+    strip_groups(child);
+  }
+}
+
+bool Regex_Optimizer::literal(const Regex_Node& tree, string& str)
+{
+  str.clear();
+  if (tree.type == Type::EMPTY)
+  {
+    return true;
+  }
+
+  if (tree.type == Type::CHARACTER)
+  {
+    if (tree.chars.count() != 1)
+      return false;
+
+    str += first_char(tree.chars);
+    return true;
+  }
+
+  if (tree.type != Type::CONCATENATION)
+  {
+    return false;
+  }
+
+  for (auto& child : tree.children)
+  {
+    if (child->type != Type::CHARACTER || child->chars.count() != 1)
+      return false;
+
+    str += first_char(child->chars);
+  }
+
+  return true;
+}
+
+void Regex_Optimizer::simplify(unique_ptr<Regex_Node>& node)
+{
+  for (auto& child : node->children)
+  {
+    simplify(child);
+  }
+
+  switch (node->type)
+  {
+    case Type::CONCATENATION:
+      simplify_concatenation(node);
+      break;
+
+    case Type::ALTERNATION:
+      simplify_alternation(node);
+      break;
+
+    case Type::CLOSURE:
+      simplify_closure(node);
+      break;
+
+    default:
+      break;
+  }
+}
+
+void Regex_Optimizer::flatten(Regex_Node& node)
+{
+  vector<unique_ptr<Regex_Node>> result;
+  for (auto& child : node.children)
+  {
+    if (child->type == node.type)
+    {
+      for (auto& grandchild : child->children)
+      {
+        result.push_back(std::move(grandchild));
+      }
+    }
+    else
+    {
+      result.push_back(std::move(child));
+    }
+  }
+
+  node.children = std::move(result);
+}
+
+void Regex_Optimizer::collapse(unique_ptr<Regex_Node>& node)
+{
+  if (node->children.empty())
+  {
+    node = std::make_unique<Regex_Node>(Type::EMPTY);
+  }
+  else if (node->children.size() == 1)
+  {
+    // Move the child out before its parent is destroyed
+    auto child {std::move(node->children.front())};
+    node = std::move(child);
+  }
+}
+
+// xy()z -> xyz, x*x* -> x*
+void Regex_Optimizer::simplify_concatenation(unique_ptr<Regex_Node>& node)
+{
+  flatten(*node);
+
+  vector<unique_ptr<Regex_Node>> result;
+  for (auto& child : node->children)
+  {
+    if (child->type == Type::EMPTY)
+      continue;
+
+    if (child->type == Type::CLOSURE && !result.empty() &&
+        *result.back() == *child)
+    {
+      continue;
+    }
+
+    result.push_back(std::move(child));
+  }
+
+  node->children = std::move(result);
+  collapse(node);
+}
+
+void Regex_Optimizer::simplify_alternation(unique_ptr<Regex_Node>& node)
+{
+  flatten(*node);
+  dedupe_alternatives(*node);
+  factor_alternatives(*node, true);
+  factor_alternatives(*node, false);
+  merge_characters(*node);
+  flatten(*node);
+
+  // ()|x* -> x*
+  bool has_nullable {false};
+  for (auto& child : node->children)
+  {
+    if (child->type != Type::EMPTY && child->nullable())
+      has_nullable = true;
+  }
+
+  if (has_nullable)
+  {
+    auto& alts {node->children};
+    alts.erase(std::remove_if(alts.begin(), alts.end(),
+          [](const unique_ptr<Regex_Node>& n)
+          { return n->type == Type::EMPTY; }), alts.end());
+  }
+
+  collapse(node);
+}
+
+void Regex_Optimizer::simplify_closure(unique_ptr<Regex_Node>& node)
+{
+  auto& child {node->children.front()};
+
+  // (x*)* -> x*, ()* -> ()
+  if (child->type == Type::CLOSURE || child->type == Type::EMPTY)
+  {
+    auto tmp {std::move(child)};
+    node = std::move(tmp);
+    return;
+  }
+
+  // (x*y*)* -> (x|y)*
+  if (child->type == Type::CONCATENATION &&
+      std::all_of(child->children.begin(), child->children.end(),
+        [](const unique_ptr<Regex_Node>& n)
+        { return n->type == Type::CLOSURE; }))
+  {
+    child->type = Type::ALTERNATION;
+  }
+
+  // (x*|y|())* -> (x|y)*
+  if (child->type == Type::ALTERNATION)
+  {
+    vector<unique_ptr<Regex_Node>> result;
+    for (auto& alt : child->children)
+    {
+      if (alt->type == Type::CLOSURE)
+        result.push_back(std::move(alt->children.front()));
+      else if (alt->type != Type::EMPTY)
+        result.push_back(std::move(alt));
+    }
+
+    child->children = std::move(result);
+    simplify_alternation(child);
+
+    if (child->type == Type::CLOSURE || child->type == Type::EMPTY)
+    {
+      auto tmp {std::move(child)};
+      node = std::move(tmp);
+    }
+  }
+}
+
+void Regex_Optimizer::dedupe_alternatives(Regex_Node& node)
+{
+  vector<unique_ptr<Regex_Node>> result;
+  for (auto& child : node.children)
+  {
+    auto dup {std::find_if(result.begin(), result.end(),
+        [&child](const unique_ptr<Regex_Node>& n) { return *n == *child; })};
+
+    if (dup == result.end())
+      result.push_back(std::move(child));
+  }
+
+  node.children = std::move(result);
+}
+
+/*
+ * Returns the first (or last) factor of an alternative
+ */
+static Regex_Node& edge(Regex_Node& node, bool prefix)
+{
+  if (node.type != Type::CONCATENATION)
+    return node;
+
+  return prefix ? *node.children.front() : *node.children.back();
+}
+
+/*
+ * Removes the first (or last) factor of an alternative
+ */
+static unique_ptr<Regex_Node> remove_edge(unique_ptr<Regex_Node> node,
+    bool prefix)
+{
+  if (node->type != Type::CONCATENATION)
+    return std::make_unique<Regex_Node>(Type::EMPTY);
+
+  auto& factors {node->children};
+  factors.erase(prefix ? factors.begin() : factors.end() - 1);
+
+  if (factors.size() == 1)
+  {
+    auto tmp {std::move(factors.front())};
+    return tmp;
+  }
+
+  return node;
+}
+
+// xy|xz -> x(y|z) (prefix), yx|zx -> (y|z)x (suffix)
+void Regex_Optimizer::factor_alternatives(Regex_Node& node, bool prefix)
+{
+  auto& alts {node.children};
+
+  // Group alternatives by their first (or last) factor
+  vector<vector<size_t>> groups;
+  bool factored {false};
+  for (size_t i {0}; i < alts.size(); i++)
+  {
+    auto group {groups.end()};
+    if (alts[i]->type != Type::EMPTY)
+    {
+      group = std::find_if(groups.begin(), groups.end(),
+          [&](const vector<size_t>& g)
+          {
+            return alts[g.front()]->type != Type::EMPTY &&
+              edge(*alts[g.front()], prefix) == edge(*alts[i], prefix);
+          });
+    }
+
+    if (group == groups.end())
+    {
+      groups.push_back({i});
+    }
+    else
+    {
+      group->push_back(i);
+      factored = true;
+    }
+  }
+
+  if (!factored)
+  {
+    return;
+  }
+
+  vector<unique_ptr<Regex_Node>> result;
+  for (auto& group : groups)
+  {
+    if (group.size() == 1)
+    {
+      result.push_back(std::move(alts[group.front()]));
+      continue;
+    }
+
+    auto common {edge(*alts[group.front()], prefix).clone()};
+    auto rest {std::make_unique<Regex_Node>(Type::ALTERNATION)};
+    for (auto i : group)
+    {
+      rest->children.push_back(remove_edge(std::move(alts[i]), prefix));
+    }
+
+    unique_ptr<Regex_Node> joined;
+    if (prefix)
+    {
+      joined = std::make_unique<Regex_Node>(Type::CONCATENATION,
+          std::move(common), std::move(rest));
+    }
+    else
+    {
+      joined = std::make_unique<Regex_Node>(Type::CONCATENATION,
+          std::move(rest), std::move(common));
+    }
+
+    simplify(joined);
+    result.push_back(std::move(joined));
+  }
+
+  alts = std::move(result);
+}
+
+// a|x|[bc] -> [abc]|x
+void Regex_Optimizer::merge_characters(Regex_Node& node)
+{
+  Regex_Node* merged {nullptr};
+  vector<unique_ptr<Regex_Node>> result;
+  for (auto& child : node.children)
+  {
+    if (child->type == Type::CHARACTER)
+    {
+      if (merged != nullptr)
+      {
+        merged->chars |= child->chars;
+        continue;
+      }
+
+      merged = child.get();
+    }
+
+    result.push_back(std::move(child));
+  }
+
+  node.children = std::move(result);
+}
@@ -0,0 +1,77 @@
+#ifndef REGEX_OPTIMIZER_H
+#define REGEX_OPTIMIZER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Regex_AST.h"
+
+/*
+ * A class that rewrites a regex syntax tree into a smaller tree
+ * matching the same language.
+ * The passes are applied bottom-up:
+ *   - nested concatenations and alternations are flattened
+ *   - nested closures are flattened, (x*)* -> x*, (x*|y)* -> (x|y)*
+ *   - duplicate alternatives are removed, a|a -> a
+ *   - common prefixes and suffixes are factored, ab|ac -> a(b|c)
+ *   - single character alternatives are merged, a|[bc] -> [abc]
+ *
+ * Capture groups are removed first unless they are kept, in which case
+ * they are left in place and only their contents are simplified.
+ */
+class Regex_Optimizer
+{
+  private:
+
+    /*
+     * Private constructor
+     */
+    Regex_Optimizer() {}
+
+    /*
+     * Simplifies the tree rooted at node. node may be replaced.
+     */
+    static void simplify(std::unique_ptr<Regex_Node>& node);
+    static void simplify_concatenation(std::unique_ptr<Regex_Node>& node);
+    static void simplify_alternation(std::unique_ptr<Regex_Node>& node);
+    static void simplify_closure(std::unique_ptr<Regex_Node>& node);
+
+    /*
+     * Replaces children of the same type as node with their children
+     */
+    static void flatten(Regex_Node& node);
+
+    /*
+     * Alternation passes
+     */
+    static void dedupe_alternatives(Regex_Node& node);
+    static void factor_alternatives(Regex_Node& node, bool prefix);
+    static void merge_characters(Regex_Node& node);
+
+    /*
+     * Replaces a node with one or no children by the child or by EMPTY
+     */
+    static void collapse(std::unique_ptr<Regex_Node>& node);
+
+    /*
+     * Replaces every GROUP node by its child
+     */
+    static void strip_groups(std::unique_ptr<Regex_Node>& node);
+
+  public:
+
+    /*
+     * Runs the optimizer pipeline over a tree
+     */
+    static std::unique_ptr<Regex_Node> optimize(
+        std::unique_ptr<Regex_Node> tree, bool keep_groups = false);
+
+    /*
+     * Returns true iff the tree matches exactly one string.
+     * The string is stored in str.
+     */
+    static bool literal(const Regex_Node& tree, std::string& str);
+};
+
+#endif
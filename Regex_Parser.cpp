@@ -12,6 +12,8 @@
 #include <string.h>
 
 #include "NFA.h"
+#include "Regex_AST.h"
+#include "Regex_Optimizer.h"
 #include "Regex_Parser.h"
 
 using namespace std;
@@ -19,36 +21,39 @@ using namespace std;
 static const char ALPHABET_BEGIN {' '};
 static const char ALPHABET_END {'~'};
 
-size_t Regex_Parser::parse_location {0};
-
-char* Regex_Parser::input;
-
 unique_ptr<NFA> Regex_Parser::regex_to_nfa(const std::string& regex)
 {
-  parse_location = 0;
+  auto tree {Regex_Optimizer::optimize(regex_to_ast(regex))};
+  return tree->to_nfa();
+}
 
-  auto cpy {regex};
-  remove_spaces(cpy);
-  input = new char[cpy.length() + 1];
-  
-  strcpy(input, cpy.c_str());
+unique_ptr<Regex_Node> Regex_Parser::regex_to_ast(const std::string& regex)
+{
+  auto cpy {normalize(regex)};
+  Regex_Parser parser(cpy.c_str());
 
   // Parse the regex
-  unique_ptr<NFA> result = goal();
+  unique_ptr<Regex_Node> result = parser.goal();
 
-  if (parse_location < cpy.length())
+  if (parser.parse_location < cpy.length())
   {
-    string msg = string("Invalid ") + input[parse_location] + " character";
-    delete [] input;
+    string msg = string("Invalid ") + cpy[parser.parse_location] +
+      " character";
     throw runtime_error(msg);
   }
   else
   { 
-    delete [] input;
     return result;
   }
 }
 
+string Regex_Parser::normalize(const std::string& regex)
+{
+  auto cpy {regex};
+  remove_spaces(cpy);
+  return cpy;
+}
+
 void Regex_Parser::remove_spaces(string& str)
 {
   auto part_end {std::stable_partition(str.begin(), str.end(), 
@@ -60,32 +65,33 @@ void Regex_Parser::remove_spaces(string& str)
 /*
  * Regular Expression Syntax Parser
  * Simultaneously validates the regex syntax and constructs
- * the resulting NFA
+ * the resulting syntax tree
  */
 
 // Goal -> Expr
-unique_ptr<NFA> Regex_Parser::goal()
+unique_ptr<Regex_Node> Regex_Parser::goal()
 {
   return expr();
 }
 
 // Expr -> TermE'
-unique_ptr<NFA> Regex_Parser::expr()
+unique_ptr<Regex_Node> Regex_Parser::expr()
 {
-  auto nfa {term()};
+  auto node {term()};
   auto operand {e_prime()};
   if (operand != nullptr)
   {
     // Scanned two terms. Take the alternation of the two operands
-    nfa->disjunction(operand);
+    node = std::make_unique<Regex_Node>(Regex_Node::Type::ALTERNATION,
+        std::move(node), std::move(operand));
   }
 
-  return nfa;
+  return node;
 }
 
 // E' -> |TermE'
 // E' -> ""
-unique_ptr<NFA> Regex_Parser::e_prime()
+unique_ptr<Regex_Node> Regex_Parser::e_prime()
 {
   if (input[parse_location] == '|')
   {
@@ -97,7 +103,8 @@ unique_ptr<NFA> Regex_Parser::e_prime()
     if (op2 != nullptr)
     {
       // Scanned two terms. Take the alternation of the two operands
-      op1->disjunction(op2);
+      op1 = std::make_unique<Regex_Node>(Regex_Node::Type::ALTERNATION,
+          std::move(op1), std::move(op2));
     }
 
     return op1;
@@ -110,17 +117,18 @@ unique_ptr<NFA> Regex_Parser::e_prime()
 }
 
 // Term -> closureT'
-unique_ptr<NFA> Regex_Parser::term()
+unique_ptr<Regex_Node> Regex_Parser::term()
 {
-  auto nfa {closure()};
-  unique_ptr<NFA> operand = t_prime();
+  auto node {closure()};
+  unique_ptr<Regex_Node> operand = t_prime();
   if (operand != nullptr)
   {
     // Scanned another closure. Concatenate the operands
-    nfa->concatenate(operand);
+    node = std::make_unique<Regex_Node>(Regex_Node::Type::CONCATENATION,
+        std::move(node), std::move(operand));
   }
 
-  return nfa;
+  return node;
 }
 
 /*
@@ -140,19 +148,20 @@ bool Regex_Parser::is_escapable(char c)
 
 // T' -> closureT'
 // T' -> ""
-unique_ptr<NFA> Regex_Parser::t_prime()
+unique_ptr<Regex_Node> Regex_Parser::t_prime()
 {
   char c = input[parse_location];
   if (c == '(' || c == '[' || c == '\\' ||
       (c <= ALPHABET_END && c >= ALPHABET_BEGIN && !is_special(c)))
   {
-    unique_ptr<NFA> op1 = closure();
-    unique_ptr<NFA> op2 = t_prime();
+    unique_ptr<Regex_Node> op1 = closure();
+    unique_ptr<Regex_Node> op2 = t_prime();
 
     if (op2 != nullptr)
     {
       // Scanned another closure. Concatenate the operands
-      op1->concatenate(op2);
+      op1 = std::make_unique<Regex_Node>(Regex_Node::Type::CONCATENATION,
+          std::move(op1), std::move(op2));
     }
 
     return op1;
@@ -170,29 +179,33 @@ unique_ptr<NFA> Regex_Parser::t_prime()
 }
 
 // closure -> FactorF
-unique_ptr<NFA> Regex_Parser::closure()
+unique_ptr<Regex_Node> Regex_Parser::closure()
 {
-  auto nfa {factor()};
-  f(nfa);
-  return nfa;
+  auto node {factor()};
+  f(node);
+  return node;
 }
 
 // Factor -> (Expr)
 // Factor -> character
 // Factor -> bracket
-unique_ptr<NFA> Regex_Parser::factor()
+unique_ptr<Regex_Node> Regex_Parser::factor()
 {
   char c {input[parse_location]};
 
   if (c == '(')
   {
     parse_location++;
-    unique_ptr<NFA> ret {expr()};
+    unsigned group {++group_count};
+    unique_ptr<Regex_Node> ret {expr()};
 
     c = input[parse_location];
     if (c == ')')
     {
       parse_location++;
+      ret = std::make_unique<Regex_Node>(Regex_Node::Type::GROUP,
+          std::move(ret));
+      ret->group = group;
       return ret;
     }
     else
@@ -212,19 +225,20 @@ unique_ptr<NFA> Regex_Parser::factor()
 
 // f -> *
 // f -> ""
-void Regex_Parser::f(unique_ptr<NFA>& nfa)
+void Regex_Parser::f(unique_ptr<Regex_Node>& node)
 {
   char c {input[parse_location]};
   if (c == '*')
   {
-    nfa->closure();
+    node = std::make_unique<Regex_Node>(Regex_Node::Type::CLOSURE,
+        std::move(node));
     parse_location++;
   }
 }
 
 // character -> non_escapable_ascii
 // character -> \escapable_ascii            
-unique_ptr<NFA> Regex_Parser::character()
+unique_ptr<Regex_Node> Regex_Parser::character()
 {
   char new_char = input[parse_location];
   if (new_char == '\\')
@@ -266,11 +280,11 @@ unique_ptr<NFA> Regex_Parser::character()
   }
 
   parse_location++;
-  return std::make_unique<NFA>(new_char);
+  return std::make_unique<Regex_Node>(new_char);
 }
 
 // bracket -> [bracket_prime
-unique_ptr<NFA> Regex_Parser::bracket()
+unique_ptr<Regex_Node> Regex_Parser::bracket()
 {
   parse_location++;
   return bracket_prime();
@@ -278,9 +292,8 @@ unique_ptr<NFA> Regex_Parser::bracket()
 
 // bracket_prime -> element_list]
 // bracket_prime -> ^element_list]
-unique_ptr<NFA> Regex_Parser::bracket_prime()
+unique_ptr<Regex_Node> Regex_Parser::bracket_prime()
 {
-  unique_ptr<NFA> ret = nullptr;
   unordered_set<char> set;
 
   bool complement = input[parse_location] == '^';
@@ -296,25 +309,18 @@ unique_ptr<NFA> Regex_Parser::bracket_prime()
   }
 
   parse_location++;
-  // Build an NFA from the characters in the bracket
+  // Collect the characters matched by the bracket
+  Char_Set chars;
   for (char c {ALPHABET_BEGIN}; c <= ALPHABET_END; c++)
   {
     if ((complement && set.find(c) == set.end()) || 
         (!complement && set.find(c) != set.end()))
     {
-      if (ret == nullptr)
-      {
-        ret = std::make_unique<NFA>(c);
-      }
-      else
-      {
-        unique_ptr<NFA> op1 = std::make_unique<NFA>(c);
-        ret->disjunction(op1);
-      }
+      chars.set(c);
     }
   }
  
-  return ret;
+  return std::make_unique<Regex_Node>(chars);
 }
 
 // element_list -> begin more
@@ -5,13 +5,19 @@
 #include <unordered_set>
 #include <string>
 #include <vector>
+#include <memory>
+
+#include "NFA.h"
+#include "Regex_AST.h"
 
 /*
  * A class that implements a regular expression parser.
  * Parses the LL(1) regex grammar using a top-down
  * recursive decent parser.
- * Also constructs an equivalent NFA from the regex while
- * parsing.
+ * Builds a syntax tree for the regex while parsing. The tree is
+ * optimized before an equivalent NFA is constructed from it.
+ * Each parse uses its own parser object, so regexes can be parsed
+ * concurrently.
  */
 class Regex_Parser
 {
@@ -20,17 +26,23 @@ class Regex_Parser
     /*
      * Private constructor
      */
-    Regex_Parser() {}
+    Regex_Parser(const char* regex) :
+      parse_location(0), input(regex), group_count(0) {}
 
     /*
      * The current location in the parse
      */
-    static size_t parse_location;
+    size_t parse_location;
 
     /*
      * The input regex
      */
-    static char* input;
+    const char* input;
+
+    /*
+     * The number of capture groups opened so far
+     */
+    unsigned group_count;
     
     /*
      * Returns true iff c is a special character
@@ -50,23 +62,23 @@ class Regex_Parser
    /*
     * Parser functions
     */ 
-    static std::unique_ptr<NFA> goal();
-    static std::unique_ptr<NFA> expr();
-    static std::unique_ptr<NFA> e_prime();
-    static std::unique_ptr<NFA> term();
-    static std::unique_ptr<NFA> t_prime();
-    static std::unique_ptr<NFA> closure();
-    static std::unique_ptr<NFA> factor();
-    static void f(std::unique_ptr<NFA>& nfa);
-    static std::unique_ptr<NFA> character();
-    static std::unique_ptr<NFA> bracket();
-    static std::unique_ptr<NFA> bracket_prime();
-    static void element_list(std::unordered_set<char>& set);
-    static void begin(std::unordered_set<char>& set);
-    static char b_prime();
-    static void element(std::unordered_set<char>& set);
-    static char element_prime(char start);
-    static void more(std::unordered_set<char>& set);
+    std::unique_ptr<Regex_Node> goal();
+    std::unique_ptr<Regex_Node> expr();
+    std::unique_ptr<Regex_Node> e_prime();
+    std::unique_ptr<Regex_Node> term();
+    std::unique_ptr<Regex_Node> t_prime();
+    std::unique_ptr<Regex_Node> closure();
+    std::unique_ptr<Regex_Node> factor();
+    void f(std::unique_ptr<Regex_Node>& node);
+    std::unique_ptr<Regex_Node> character();
+    std::unique_ptr<Regex_Node> bracket();
+    std::unique_ptr<Regex_Node> bracket_prime();
+    void element_list(std::unordered_set<char>& set);
+    void begin(std::unordered_set<char>& set);
+    char b_prime();
+    void element(std::unordered_set<char>& set);
+    char element_prime(char start);
+    void more(std::unordered_set<char>& set);
 
   public:
 
@@ -74,6 +86,18 @@ class Regex_Parser
      * Converts the regular expression to an NFA
      */
     static std::unique_ptr<NFA> regex_to_nfa(const std::string& regex);
+
+    /*
+     * Converts the regular expression to an unoptimized syntax tree.
+     * Each pair of parentheses becomes a GROUP node, numbered in the
+     * order of the opening parentheses.
+     */
+    static std::unique_ptr<Regex_Node> regex_to_ast(const std::string& regex);
+
+    /*
+     * Returns the regex with the blanks the parser ignores removed
+     */
+    static std::string normalize(const std::string& regex);
 };
 
 #endif
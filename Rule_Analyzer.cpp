@@ -0,0 +1,72 @@
+/*
+ * Rule_Analyzer implementation file
+ */
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "DFA.h"
+#include "Regex_Compiler.h"
+#include "Rule_Analyzer.h"
+
+using namespace std;
+
+vector<Rule_Analyzer::Finding> Rule_Analyzer::analyze(
+    const vector<string>& rules, const Compile_Limits& limits)
+{
+  vector<unique_ptr<DFA>> dfas;
+  for (size_t i {0}; i < rules.size(); i++)
+  {
+    try
+    {
+      dfas.push_back(Regex_Compiler::compile_dfa(rules[i], limits));
+    }
+    catch (Compile_Limit_Error&)
+    {
+      throw;
+    }
+    catch (std::runtime_error& e)
+    {
+      throw runtime_error("Rule " + to_string(i) + ": " + e.what());
+    }
+  }
+
+  vector<Finding> findings;
+  vector<bool> duplicate(rules.size());
+  for (size_t i {0}; i < rules.size(); i++)
+  {
+    for (size_t j {0}; j < i; j++)
+    {
+      if (!duplicate[j] && DFA::equivalent(*dfas[i], *dfas[j]))
+      {
+        duplicate[i] = true;
+        findings.push_back({Finding::Kind::DUPLICATE, i, j});
+        break;
+      }
+    }
+  }
+
+  // Only the first of equal rules can subsume, and it keeps the others
+  for (size_t i {0}; i < rules.size(); i++)
+  {
+    if (duplicate[i])
+      continue;
+
+    for (size_t j {0}; j < rules.size(); j++)
+    {
+      if (j != i && !duplicate[j] && DFA::contained(*dfas[i], *dfas[j]))
+      {
+        findings.push_back({Finding::Kind::SUBSUMED, i, j});
+        break;
+      }
+    }
+  }
+
+  std::sort(findings.begin(), findings.end(),
+      [](const Finding& a, const Finding& b) { return a.rule < b.rule; });
+
+  return findings;
+}
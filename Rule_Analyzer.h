@@ -0,0 +1,53 @@
+#ifndef RULE_ANALYZER_H
+#define RULE_ANALYZER_H
+
+#include <string>
+#include <vector>
+
+#include "Compile_Limits.h"
+
+/*
+ * A class that finds the redundant rules of a rule set: rules that match
+ * the same language as an earlier rule, and rules whose language is
+ * contained in another rule's. Either kind can be dropped from a set of
+ * alternatives without changing what the set matches.
+ */
+class Rule_Analyzer
+{
+  private:
+
+    /*
+     * Private constructor
+     */
+    Rule_Analyzer() {}
+
+  public:
+
+    // A redundant rule
+    class Finding
+    {
+      public:
+        enum class Kind {DUPLICATE, SUBSUMED};
+
+        Kind kind;
+
+        // Index of the redundant rule
+        size_t rule;
+
+        // Index of the rule that makes it redundant
+        size_t by;
+    };
+
+    /*
+     * Reports each redundant rule once, in order. A rule is a duplicate
+     * of the first earlier rule with the same language, and otherwise
+     * subsumed by the first rule, other than a duplicate, with a strictly
+     * larger language.
+     * Throws std::runtime_error naming the rule if a rule is invalid, and
+     * Compile_Limit_Error if one goes over the limits.
+     */
+    static std::vector<Finding> analyze(const std::vector<std::string>& rules,
+        const Compile_Limits& limits = Compile_Limits());
+};
+
+#endif
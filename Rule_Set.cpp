@@ -0,0 +1,160 @@
+/*
+ * Rule_Set implementation file
+ */
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#include "DFA.h"
+#include "DFA_Matcher.h"
+#include "Regex_Compiler.h"
+#include "Rule_Set.h"
+
+using namespace std;
+
+const unsigned Rule_Set::DEFAULT_SHARDS {16};
+
+Rule_Set::Rule_Set(unsigned shard_count, const Compile_Limits& l) :
+  shards(max(shard_count, 1u)), limits(l)
+{
+}
+
+Rule_Set::Read_Guard::Read_Guard(const Rule_Set& s) : set(s)
+{
+  // Retry if an update advanced the epoch before the reader was counted
+  for (;;)
+  {
+    auto e {set.epoch.load()};
+    parity = e & 1;
+    set.readers[parity].fetch_add(1);
+    if (set.epoch.load() == e)
+      break;
+
+    set.readers[parity].fetch_sub(1);
+  }
+}
+
+Rule_Set::Read_Guard::~Read_Guard()
+{
+  set.readers[parity].fetch_sub(1, memory_order_release);
+}
+
+void Rule_Set::synchronize()
+{
+  auto parity {epoch.fetch_add(1) & 1};
+  while (readers[parity].load(memory_order_acquire) != 0)
+  {
+    this_thread::yield();
+  }
+}
+
+void Rule_Set::rebuild(Shard& shard)
+{
+  unique_ptr<const DFA_Matcher> matcher;
+  if (!shard.rules.empty())
+  {
+    // Union the rules' DFAs, minimizing as it goes
+    Compile_Budget budget {limits};
+    auto it {shard.rules.begin()};
+    DFA combined {*it->second};
+    for (it++; it != shard.rules.end(); it++)
+    {
+      combined = DFA::product(combined, *it->second, DFA::Operation::UNION,
+          &budget);
+    }
+
+    matcher = std::make_unique<const DFA_Matcher>(combined);
+  }
+
+  shard.matcher.store(matcher.get());
+  synchronize();
+  shard.owned = std::move(matcher);
+}
+
+uint64_t Rule_Set::add(const string& regex)
+{
+  // Compile the rule before taking the lock, so updates only wait for
+  // each other's shard rebuilds
+  auto dfa {Regex_Compiler::compile_dfa(regex, limits)};
+
+  lock_guard<std::mutex> lock {mutex};
+  uint64_t id {next_id++};
+  auto& shard {shard_of(id)};
+
+  shard.rules.emplace(id, std::move(dfa));
+  try
+  {
+    rebuild(shard);
+  }
+  catch (...)
+  {
+    // Keep the rules in step with the published matcher
+    shard.rules.erase(id);
+    throw;
+  }
+
+  rule_count.fetch_add(1, memory_order_relaxed);
+  return id;
+}
+
+bool Rule_Set::remove(uint64_t id)
+{
+  lock_guard<std::mutex> lock {mutex};
+  auto& shard {shard_of(id)};
+
+  auto it {shard.rules.find(id)};
+  if (it == shard.rules.end())
+  {
+    return false;
+  }
+
+  auto dfa {std::move(it->second)};
+  shard.rules.erase(it);
+  try
+  {
+    rebuild(shard);
+  }
+  catch (...)
+  {
+    shard.rules.emplace(id, std::move(dfa));
+    throw;
+  }
+
+  rule_count.fetch_sub(1, memory_order_relaxed);
+  return true;
+}
+
+bool Rule_Set::accept(string_view input) const
+{
+  Read_Guard guard {*this};
+  for (auto& shard : shards)
+  {
+    auto matcher {shard.matcher.load()};
+    if (matcher != nullptr && matcher->accept(input))
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool Rule_Set::search(string_view input) const
+{
+  Read_Guard guard {*this};
+  for (auto& shard : shards)
+  {
+    auto matcher {shard.matcher.load()};
+    if (matcher != nullptr && matcher->search(input))
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
@@ -0,0 +1,138 @@
+#ifndef RULE_SET_H
+#define RULE_SET_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "Compile_Limits.h"
+#include "DFA.h"
+#include "DFA_Matcher.h"
+
+/*
+ * A set of rules that can be changed while it is being matched.
+ *
+ * The rules are spread over shards, each matched by one DFA recognizing
+ * the union of its rules. Changing a rule rebuilds only its shard, from
+ * the minimal DFAs of the shard's rules kept since they were added, so
+ * no other rule is parsed or compiled again.
+ *
+ * Updates are read-copy-update: a rebuilt shard matcher is published by
+ * swapping an atomic pointer, readers holding the old matcher keep using
+ * it until they are done, and readers never wait for a rebuild. Updates
+ * are serialized with each other.
+ */
+class Rule_Set
+{
+  private:
+
+    class Shard
+    {
+      public:
+        // The minimal DFA of each rule, by rule id
+        std::map<uint64_t, std::unique_ptr<DFA>> rules;
+
+        // Matcher for the union of the rules, null if there are none
+        std::unique_ptr<const DFA_Matcher> owned;
+
+        // The matcher readers use
+        std::atomic<const DFA_Matcher*> matcher {nullptr};
+    };
+
+    /*
+     * Marks a reader as active from construction to destruction.
+     *
+     * Readers count themselves in one of two counters picked by the
+     * parity of the epoch. An update publishes its matcher, advances the
+     * epoch and waits for the readers counted under the old parity, who
+     * may still hold the old matcher, before freeing it. Readers never
+     * wait.
+     */
+    class Read_Guard
+    {
+      private:
+        const Rule_Set& set;
+        unsigned parity;
+
+      public:
+        Read_Guard(const Rule_Set& set);
+        ~Read_Guard();
+    };
+
+    // Updates so far, and the active readers by epoch parity
+    std::atomic<uint64_t> epoch {0};
+    mutable std::atomic<uint64_t> readers[2] {};
+
+    std::deque<Shard> shards;
+
+    // Limits applied to the rules and to the shard unions
+    Compile_Limits limits;
+
+    // Serializes updates
+    std::mutex mutex;
+
+    uint64_t next_id {0};
+    std::atomic<size_t> rule_count {0};
+
+    Shard& shard_of(uint64_t id) { return shards[id % shards.size()]; }
+
+    /*
+     * Rebuilds and publishes a shard's matcher, and frees the old one
+     * once no reader holds it. The mutex must be held.
+     */
+    void rebuild(Shard& shard);
+
+    /*
+     * Waits until every reader active before the call is done
+     */
+    void synchronize();
+
+  public:
+
+    /*
+     * Default number of shards
+     */
+    static const unsigned DEFAULT_SHARDS;
+
+    /*
+     * Constructs an empty set with shard_count shards
+     */
+    Rule_Set(unsigned shard_count = DEFAULT_SHARDS,
+        const Compile_Limits& limits = Compile_Limits());
+
+    /*
+     * Adds a rule, returning its id.
+     * Throws std::runtime_error if the regex is invalid, and
+     * Compile_Limit_Error if the rule or its shard goes over the limits.
+     * The set is left unchanged if anything is thrown.
+     */
+    uint64_t add(const std::string& regex);
+
+    /*
+     * Removes a rule. Returns false if there is no rule with that id.
+     * The set is left unchanged if rebuilding the shard throws.
+     */
+    bool remove(uint64_t id);
+
+    /*
+     * Returns true iff some rule recognizes the whole input
+     */
+    bool accept(std::string_view input) const;
+
+    /*
+     * Returns true iff some rule recognizes a substring of the input
+     */
+    bool search(std::string_view input) const;
+
+    /*
+     * Returns the number of rules
+     */
+    size_t size() const { return rule_count.load(std::memory_order_relaxed); }
+};
+
+#endif